@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cstring>
 
 #include "spdlog/spdlog.h"
 
@@ -121,30 +122,26 @@ IMU CoppeliaSimRobot::read_imu() const {
 //   chassis.attitude.pitch = beta;
 // }
 
-std::vector<uint8_t> CoppeliaSimRobot::read_camera_image() const {
+bool CoppeliaSimRobot::read_camera_image(CameraFrame *frame) const {
   if (!camera_handle)
-    return {};
+    return false;
   simHandleVisionSensor(camera_handle, nullptr, nullptr);
   simInt width = 0;
   simInt height = 0;
   simUChar *buffer = simGetVisionSensorCharImage(camera_handle, &width, &height);
-  if (width != camera.width || height != camera.height) {
+  if (width != static_cast<simInt>(frame->width) || height != static_cast<simInt>(frame->height)) {
     spdlog::warn("Skip frame because of uncorrect size ({}, {}) vs desired size ({}, {})", width,
-                 height, camera.width, camera.height);
-    return {};
+                 height, frame->width, frame->height);
+    simReleaseBuffer((const simChar *)buffer);
+    return false;
   }
-  unsigned size = width * height * 3;
-  // std::vector image(buffer, buffer + size);
-  std::vector<uint8_t> image;
-  image.reserve(size);
   simInt resolution[2] = {width, height};
   simTransformImage(buffer, resolution, 4, nullptr, nullptr, nullptr);
-
-  std::copy(buffer, buffer + size, std::back_inserter(image));
-  // image = std::vector(image);
+  // The only copy: CoppeliaSim owns the buffer
+  memcpy(frame->data(), buffer, frame->size());
   simReleaseBuffer((const simChar *)buffer);
   spdlog::debug("Got a {} x {} from CoppeliaSim", width, height);
-  return image;
+  return true;
 }
 
 bool CoppeliaSimRobot::forward_camera_resolution(unsigned width, unsigned height) {
@@ -226,8 +223,6 @@ Gripper::Status CoppeliaSimRobot::read_gripper_state() const {
 
 DetectedObjects CoppeliaSimRobot::read_detected_objects() const { return {}; }
 
-hit_event_t CoppeliaSimRobot::read_hit_events() const { return {}; }
-
 float CoppeliaSimRobot::read_tof(size_t index) const {
   if (!tof_handles.count(index)) return 0.0f;
   simInt h = tof_handles.at(index);
@@ -241,8 +236,6 @@ float CoppeliaSimRobot::read_tof(size_t index) const {
   return 0.0f;
 }
 
-ir_event_t CoppeliaSimRobot::read_ir_events() const { return {}; }
-
 void CoppeliaSimRobot::enable_tof(size_t index, simInt sensor_handle) {
   if (index < MAX_NUMBER_OF_TOF_SENSORS && Robot::enable_tof(index)) {
     tof_handles[index] = sensor_handle;
@@ -106,7 +106,7 @@ static int add_robot(int coppelia_index, std::string serial_number,
                      std::string remote_api_network = "", bool enable_camera = true,
                      bool camera_use_udp = false, int camera_bitrate = 1000000,
                      bool enable_arm = true, bool enable_gripper = true,
-                     bool enable_gimbal = true) {
+                     bool enable_gimbal = true, Encoder::Backend camera_encoder = Encoder::x264) {
   int handle = next_robot_handle;
   std::string suffix = "#";
   if (coppelia_index >= 0) {
@@ -198,6 +198,7 @@ static int add_robot(int coppelia_index, std::string serial_number,
     _interfaces.emplace(handle, std::make_unique<RoboMaster>(nullptr, _robots[handle].get(),
                                                              serial_number, camera_use_udp,
                                                              camera_bitrate, ip, prefix_len));
+    _interfaces[handle]->set_video_encoder(camera_encoder);
     _interfaces[handle]->spin(true);
   }
   next_robot_handle += 1;
@@ -205,16 +206,13 @@ static int add_robot(int coppelia_index, std::string serial_number,
   return handle;
 }
 
-static const std::map<std::string, int> action_handles = {
-    {"move", 1}, {"move_arm", 2}, {"move_gimbal", 3}, {"play_sound", 4}, {"move_servo", 5}};
+static int action_handle(Action::Kind kind) { return kind + 1; }
 
-std::string action_name(int action_handle) {
-  for (auto &[name, i] : action_handles) {
-    if (i == action_handle) {
-      return name;
-    }
-  }
-  return "";
+static bool action_kind(int action_handle, Action::Kind *kind) {
+  if (action_handle < 1 || action_handle > static_cast<int>(Action::number_of_kinds))
+    return false;
+  *kind = static_cast<Action::Kind>(action_handle - 1);
+  return true;
 }
 
 class Plugin : public sim::Plugin {
@@ -246,9 +244,14 @@ class Plugin : public sim::Plugin {
   }
 
   void create(create_in *in, create_out *out) {
+    Encoder::Backend camera_encoder;
+    if (!encoder_backend_from_string(in->camera_encoder, &camera_encoder)) {
+      spdlog::warn("Unknown camera encoder {}: will use x264", in->camera_encoder);
+      camera_encoder = Encoder::x264;
+    }
     out->handle = add_robot(in->index, in->serial_number, in->remote_api_network, in->enable_camera,
                             in->camera_use_udp, in->camera_bitrate, in->enable_arm,
-                            in->enable_gripper, in->enable_gimbal);
+                            in->enable_gripper, in->enable_gimbal, camera_encoder);
   }
 
   void create_ep(create_ep_in *in, create_ep_out *out) {
@@ -340,13 +343,15 @@ class Plugin : public sim::Plugin {
     if (_robots.count(in->handle)) {
       _robots[in->handle]->move_base({.x = in->pose.x, .y = in->pose.y, .theta = in->pose.theta},
                                      in->linear_speed, in->angular_speed);
-      out->handle = action_handles.at("move");
+      out->handle = action_handle(Action::MOVE);
     }
   }
 
   void get_action_state(get_action_state_in *in, get_action_state_out *out) {
     if (_robots.count(in->handle)) {
-      auto state = _robots[in->handle]->get_action_state(action_name(in->action));
+      Action::Kind kind;
+      auto state = action_kind(in->action, &kind) ? _robots[in->handle]->get_action_state(kind)
+                                                   : Action::State::undefined;
       switch (state) {
       case Action::State::failed:
         out->status = "failed";
@@ -366,7 +371,26 @@ class Plugin : public sim::Plugin {
       case Action::State::started:
         out->status = "started";
         break;
+      case Action::State::queued:
+        out->status = "queued";
+        break;
+      }
+    }
+  }
+
+  void set_action_policy(set_action_policy_in *in, set_action_policy_out *out) {
+    if (_robots.count(in->handle)) {
+      Action::Kind kind;
+      Action::Policy policy;
+      if (!action_kind(in->action, &kind)) {
+        spdlog::warn("Unknown action handle {}", in->action);
+        return;
       }
+      if (!action_policy_from_string(in->policy, &policy)) {
+        spdlog::warn("Unknown action policy {}", in->policy);
+        return;
+      }
+      _robots[in->handle]->set_action_policy(kind, policy, std::max(0, in->max_queue_length));
     }
   }
 
@@ -434,7 +458,7 @@ class Plugin : public sim::Plugin {
     out->handle = 0;
     if (_robots.count(in->handle)) {
       _robots[in->handle]->move_arm(in->x, in->z, in->absolute);
-      out->handle = action_handles.at("move_arm");
+      out->handle = action_handle(Action::MOVE_ARM);
     }
   }
 
@@ -453,7 +477,7 @@ class Plugin : public sim::Plugin {
     if (_robots.count(in->handle)) {
       _robots[in->handle]->move_gimbal(in->yaw, in->pitch, in->yaw_speed, in->pitch_speed,
                                        gimbal_frame(in->yaw_frame), gimbal_frame(in->pitch_frame));
-      out->handle = action_handles.at("move_gimbal");
+      out->handle = action_handle(Action::MOVE_GIMBAL);
     }
   }
 
@@ -468,7 +492,7 @@ class Plugin : public sim::Plugin {
     out->handle = 0;
     if (_robots.count(in->handle)) {
       _robots[in->handle]->move_servo(in->servo, in->angle);
-      out->handle = action_handles.at("move_servo");
+      out->handle = action_handle(Action::MOVE_SERVO);
     }
   }
 
@@ -588,11 +612,129 @@ class Plugin : public sim::Plugin {
     }
   }
 
+  void hit_armor(hit_armor_in *in, hit_armor_out *out) {
+    if (_robots.count(in->handle)) {
+      _robots[in->handle]->armor.hit_events.push(
+          {.type = static_cast<uint8_t>(in->type), .index = static_cast<uint8_t>(in->index)});
+    }
+  }
+
+  void hit_ir(hit_ir_in *in, hit_ir_out *out) {
+    if (_robots.count(in->handle)) {
+      _robots[in->handle]->armor.ir_events.push(
+          {.skill_id = static_cast<uint8_t>(in->skill_id),
+           .role_id = static_cast<uint8_t>(in->role_id),
+           .recv_dev = static_cast<uint8_t>(in->recv_dev),
+           .recv_ir_pin = static_cast<uint8_t>(in->recv_ir_pin)});
+    }
+  }
+
+  void receive_uart(receive_uart_in *in, receive_uart_out *out) {
+    if (_robots.count(in->handle)) {
+      const auto &data = in->data;
+      if (!_robots[in->handle]->uart.receive(reinterpret_cast<const uint8_t *>(data.data()),
+                                             data.size())) {
+        spdlog::warn("UART buffer full: lost part of {} bytes", data.size());
+      }
+    }
+  }
+
 
   void set_log_level(set_log_level_in *in, set_log_level_out *out) {
     spdlog::set_level(spdlog::level::from_str(in->log_level));
   }
 
+  void set_real_time_topics(set_real_time_topics_in *in, set_real_time_topics_out *out) {
+    if (_interfaces.count(in->handle)) {
+      _interfaces[in->handle]->set_real_time_topics(in->value);
+    }
+  }
+
+  void set_vision_on_change(set_vision_on_change_in *in, set_vision_on_change_out *out) {
+    if (_interfaces.count(in->handle)) {
+      _interfaces[in->handle]->set_vision_on_change(in->value);
+    }
+  }
+
+  void set_publish_policy(set_publish_policy_in *in, set_publish_policy_out *out) {
+    if (_interfaces.count(in->handle)) {
+      PublishPolicy::Mode mode;
+      if (!publish_mode_from_string(in->mode, &mode)) {
+        spdlog::warn("Unknown publish mode {}", in->mode);
+        return;
+      }
+      _interfaces[in->handle]->set_publish_policy(
+          in->subject, PublishPolicy(mode, in->deadband, in->keepalive));
+    }
+  }
+
+  void set_bandwidth_budget(set_bandwidth_budget_in *in, set_bandwidth_budget_out *out) {
+    if (_interfaces.count(in->handle)) {
+      _interfaces[in->handle]->set_bandwidth_budget(in->bytes_per_second);
+    }
+  }
+
+  void set_adaptive_video_bitrate(set_adaptive_video_bitrate_in *in,
+                                  set_adaptive_video_bitrate_out *out) {
+    if (_interfaces.count(in->handle)) {
+      _interfaces[in->handle]->set_adaptive_video_bitrate(std::max(0, in->min_bitrate),
+                                                          std::max(0, in->max_bitrate));
+    }
+  }
+
+  void set_priority(set_priority_in *in, set_priority_out *out) {
+    if (_interfaces.count(in->handle)) {
+      _interfaces[in->handle]->set_priority(in->subject, in->priority);
+    }
+  }
+
+  void get_topic_stats(get_topic_stats_in *in, get_topic_stats_out *out) {
+    if (_interfaces.count(in->handle)) {
+      for (const auto &report : _interfaces[in->handle]->get_topic_stats()) {
+        CS_TopicStats value;
+        value.name = report.name;
+        value.node_id = report.node_id;
+        value.msg_id = report.msg_id;
+        value.requested_frequency = report.requested_frequency;
+        value.frequency = report.frequency;
+        value.rate = report.stats.rate();
+        value.jitter_min = report.stats.jitter_min();
+        value.jitter_avg = report.stats.jitter_avg();
+        value.jitter_max = report.stats.jitter_max();
+        value.jitter_p99 = report.stats.jitter_p99();
+        value.pushes = report.stats.pushes;
+        value.bytes = report.stats.bytes;
+        value.skipped = report.stats.skipped;
+        value.dropped = report.stats.dropped;
+        value.duplicated = report.stats.duplicated;
+        out->stats.push_back(value);
+      }
+    }
+  }
+
+  void get_video_stats(get_video_stats_in *in, get_video_stats_out *out) {
+    if (_interfaces.count(in->handle)) {
+      const auto stats = _interfaces[in->handle]->get_video_stats();
+      out->stats.frames = stats.frames;
+      out->stats.dropped = stats.dropped;
+      out->stats.encoded = stats.encoded;
+      out->stats.sent = stats.sent;
+      out->stats.sent_bytes = stats.sent_bytes;
+      out->stats.skipped = stats.skipped;
+      out->stats.latency_avg = stats.latency();
+      out->stats.latency_max = stats.latency_max;
+      out->stats.bitrate = stats.bitrate;
+      for (const auto &sample : stats.bitrate_history) {
+        CS_BitrateSample value;
+        value.time = sample.time;
+        value.bitrate = sample.bitrate;
+        value.queued_bytes = sample.queued_bytes;
+        value.latency = sample.latency;
+        out->bitrate_history.push_back(value);
+      }
+    }
+  }
+
   void get_handles(get_handles_in *in, get_handles_out *out) {
     for (auto &[key, _] : _robots) {
       out->handles.push_back(key);
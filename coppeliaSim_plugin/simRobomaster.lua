@@ -4,7 +4,7 @@ function simRobomaster.wait_for_completed(robot_handle, action_handle)
     local savedLockLevel=sim.setThreadAutomaticSwitch(false) -- forbid automatic switches
     while true do
         local s = simRobomaster.get_action_state(robot_handle, action_handle)
-        if(s ~= "running" and s ~= "started") then
+        if(s ~= "running" and s ~= "started" and s ~= "queued") then
             break
         end
         sim.switchThread()
@@ -13,17 +13,34 @@
 
 #include "protocol.hpp"
 #include "robot/robot.hpp"
+#include "scheduler.hpp"
 #include "utils.hpp"
 
 class Commands;
 
 template <typename T> struct ActionSDK {
-  void publish(float time_step) {
-    deadline -= time_step;
-    if (action->done() || deadline <= 0) {
-      deadline += 1.0f / frequency;
-      update_msg();
-      cmd->send(push_msg->encode_msg(T::set, T::cmd));
+  void publish() {
+    update_msg();
+    cmd->send(push_msg->encode_msg(T::set, T::cmd));
+  }
+
+  // Called by the robot after each step of the action and when it changes its state
+  // (e.g., starts a queued action or preempts it): pushes state transitions at once.
+  // The periodic pushes, while the action is not done, are handled by the scheduler.
+  void step(float time_step) {
+    if (action->state == last_state)
+      return;
+    last_state = action->state;
+    // Queued actions are not pushed until they start
+    if (last_state == Action::State::queued)
+      return;
+    publish();
+    if (action->done()) {
+      if (timer)
+        timer->cancel();
+    } else if (!timer) {
+      timer = cmd->get_scheduler()->schedule(
+          1.0f / frequency, std::bind(&ActionSDK::publish, this), 1.0f / frequency);
     }
   }
 
@@ -32,23 +49,28 @@ template <typename T> struct ActionSDK {
       : cmd(_cmd)
       , id(_id)
       , frequency(_frequency)
-      , deadline(0)
+      , timer()
       , push_msg(std::move(_push))
-      , action(_action) {
+      , action(_action)
+      , last_state(Action::State::undefined) {
     push_msg->action_id = id;
-    action->set_callback(std::bind(&ActionSDK::publish, this, std::placeholders::_1));
+    action->set_callback(std::bind(&ActionSDK::step, this, std::placeholders::_1));
   }
 
-  ~ActionSDK() {}
+  ~ActionSDK() {
+    if (timer)
+      timer->cancel();
+  }
 
   virtual void update_msg() = 0;
 
   Commands *cmd;
   uint8_t id;
   float frequency;
-  float deadline;
+  Scheduler::TimerPtr timer;
   std::unique_ptr<typename T::Response> push_msg;
   Action *action;
+  Action::State last_state;
 };
 
 struct PositionPush : Proto<0x3f, 0x2a> {
@@ -84,12 +106,7 @@ struct MoveActionSDK : MoveAction, ActionSDK<PositionPush> {
   }
   void update_msg() {
     push_msg->seq_id++;
-    if (state == State::succeed) {
-      push_msg->percent = 100;
-    } else {
-      push_msg->percent = std::max(
-          0, static_cast<int>(100 - round(100.0f * remaining_duration / predicted_duration)));
-    }
+    push_msg->percent = percent();
     push_msg->action_state = state;
     // std::cout << "current: " << current << std::endl;
     // TODO(Jerome): check if coherent with real robot
@@ -134,12 +151,7 @@ struct MoveArmActionSDK : MoveArmAction, ActionSDK<RoboticArmMovePush> {
 
   void update_msg() {
     push_msg->seq_id++;
-    if (state == Action::State::succeed) {
-      push_msg->percent = 100;
-    } else {
-      push_msg->percent = std::max(
-          0, static_cast<int>(100 - round(100.0f * remaining_duration / predicted_duration)));
-    }
+    push_msg->percent = percent();
     push_msg->action_state = state;
     // std::cout << "current: " << current_position << std::endl;
     // TODO(Jerome): check if coherent with real robot
@@ -180,8 +192,7 @@ struct PlaySoundActionSDK : PlaySoundAction, ActionSDK<PlaySoundPush> {
 
   void update_msg() {
     push_msg->sound_id = sound_id;
-    push_msg->percent = std::max(
-        0, static_cast<int>(100 - round(100.0f * remaining_duration / predicted_duration)));
+    push_msg->percent = percent();
     push_msg->action_state = state;
   }
 };
@@ -216,8 +227,7 @@ struct MoveServoActionSDK : MoveServoAction, ActionSDK<ServoCtrlPush> {
 
   void update_msg() {
     push_msg->value = servo_angle_value(servo_id, current_angle);
-    push_msg->percent = std::max(
-        0, static_cast<int>(100 - round(100.0f * remaining_duration / predicted_duration)));
+    push_msg->percent = percent();
     push_msg->action_state = state;
   }
 };
@@ -258,8 +268,7 @@ struct GimbalActionSDK : MoveGimbalAction, ActionSDK<GimbalActionPush> {
   void update_msg() {
     push_msg->yaw = round(rad2deg(10 * current.yaw));
     push_msg->pitch = round(rad2deg(10 * current.pitch));
-    push_msg->percent = std::max(
-        0, static_cast<int>(100 - round(100.0f * remaining_duration / predicted_duration)));
+    push_msg->percent = percent();
     push_msg->action_state = state;
   }
 };
@@ -7,6 +7,7 @@
 
 #include <boost/asio.hpp>
 
+#include "scheduler.hpp"
 #include "server.hpp"
 #include "streamer.hpp"
 #include "subject.hpp"
@@ -26,25 +27,39 @@ class Commands : public Server {
            unsigned short port = 20020, bool enable_armor_hits = false,
            bool enable_ir_hits = false);
   ~Commands();
-  void create_publisher(uint64_t uid, const AddSubMsg::Request &request);
+  void create_publisher(const AddSubMsg::Request &request);
   void stop_publisher(const DelMsg::Request &request);
   void do_step(float time_step);
   VideoStreamer *get_video_streamer();
+  Scheduler *get_scheduler();
+  // New topics are published by the IO thread at wall-clock times, not in simulation time
+  void set_real_time_topics(bool value) { real_time_topics = value; }
+  // Set the policy of the subject called `name` (e.g., "Battery"), or of all subjects if empty.
+  // Returns false if there is no subject with that name.
+  bool set_publish_policy(const std::string &name, const PublishPolicy &policy);
+  bool set_priority(const std::string &name, float priority);
+  // Limit the bytes/s sent to the client by topics and the video stream, 0 for no limit.
+  // Topics are slowed down proportionally (weighted by their priority) to fit the budget.
+  void set_bandwidth_budget(float bytes_per_second);
+  std::vector<TopicReport> get_topic_stats();
+  // Log the statistics of all topics
+  void dump_topic_stats();
   void set_vision_request(uint8_t sender, uint8_t receiver, uint16_t type);
+  // Push detected objects only when they change
+  void set_vision_on_change(bool value);
   void set_enable_sdk(bool);
   void add_subscriber_node(uint8_t node_id);
   void reset_subscriber_node(uint8_t node_id);
   void got_heartbeat();
 
  private:
-  using SubjectCreator = std::function<std::unique_ptr<Subject>()>;
-  std::map<uint64_t, SubjectCreator> subjects;
+  // One instance per subject, shared by all topics so that it is updated and encoded
+  // at most once per step, whatever the number of subscriptions.
+  std::map<uint64_t, std::unique_ptr<Subject>> subjects;
   std::map<int, std::unique_ptr<Topic>> publishers;
   void unconnect();
 
-  template <typename S> void register_subject() {
-    subjects[S::uid] = []() -> std::unique_ptr<S> { return std::make_unique<S>(); };
-  }
+  template <typename S> void register_subject() { subjects[S::uid] = std::make_unique<S>(); }
 
   RoboMaster *robomaster;
   std::unique_ptr<VisionEvent> vision_event;
@@ -53,6 +68,14 @@ class Commands : public Server {
   std::unique_ptr<UARTEvent> uart_event;
   bool enable_armor_hits;
   bool enable_ir_hits;
+  bool real_time_topics;
+  bool vision_on_change;
+  // [bytes/s]
+  float bandwidth_budget;
+  // Message sizes and the video stream change, so we check the budget regularly
+  Scheduler::TimerPtr rates_timer;
+  bool rates_need_update;
+  void update_topic_rates();
   float last_heartbeat;
   float _time;
   bool connected;
@@ -22,6 +22,7 @@ uint8_t accept_code(Action::State state) {
   switch (state) {
   case Action::State::running:
   case Action::State::started:
+  case Action::State::queued:
     return 0;
   case Action::State::succeed:
     return 2;
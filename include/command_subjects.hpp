@@ -42,7 +42,7 @@ Attitude from_robot(Attitude attitude) {
           .roll = rad2deg(normalize(attitude.roll))};
 }
 
-struct VelocitySubject : SubjectWithUID<0x0002000949a4009c> {
+struct VelocitySubject : SubjectWithSchema<0x0002000949a4009c, VelocitySubject> {
   std::string name() { return "Velocity"; }
 
   // {vgx, vgy, vgz}: The velocity in the world coordinate system [initialized] at the time of
@@ -55,17 +55,16 @@ struct VelocitySubject : SubjectWithUID<0x0002000949a4009c> {
   float vby;
   float vbz;
 
-  std::vector<uint8_t> encode() {
-    std::vector<uint8_t> buffer(4 * 6, 0);
-    write<float>(buffer, 4 * 0, vgx);
-    write<float>(buffer, 4 * 1, vgy);
-    write<float>(buffer, 4 * 2, vgz);
-    write<float>(buffer, 4 * 3, vbx);
-    write<float>(buffer, 4 * 4, vby);
-    write<float>(buffer, 4 * 5, vbz);
-    return buffer;
+  static constexpr auto fields() {
+    using S = VelocitySubject;
+    return std::make_tuple(
+        schema::field<float>(&S::vgx, "vgx"), schema::field<float>(&S::vgy, "vgy"),
+        schema::field<float>(&S::vgz, "vgz"), schema::field<float>(&S::vbx, "vbx"),
+        schema::field<float>(&S::vby, "vby"), schema::field<float>(&S::vbz, "vbz"));
   }
 
+  std::vector<float> values() { return {vgx, vgy, vgz, vbx, vby, vbz}; }
+
   void update(Robot *robot) {
     Twist2D twist_odom = from_robot(robot->chassis.get_twist(Frame::odom));
     Twist2D twist_body = from_robot(robot->chassis.get_twist(Frame::body));
@@ -78,7 +77,7 @@ struct VelocitySubject : SubjectWithUID<0x0002000949a4009c> {
   }
 };
 
-struct PositionSubject final : SubjectWithUID<0x00020009eeb7cece> {
+struct PositionSubject final : SubjectWithSchema<0x00020009eeb7cece, PositionSubject> {
   std::string name() { return "Position"; }
 
   // position3D in [m, m, m]
@@ -86,14 +85,15 @@ struct PositionSubject final : SubjectWithUID<0x00020009eeb7cece> {
   float position_y;
   float position_z;
 
-  std::vector<uint8_t> encode() {
-    std::vector<uint8_t> buffer(4 * 3, 0);
-    write<float>(buffer, 4 * 0, position_x);
-    write<float>(buffer, 4 * 1, position_y);
-    write<float>(buffer, 4 * 2, position_z);
-    return buffer;
+  static constexpr auto fields() {
+    using S = PositionSubject;
+    return std::make_tuple(schema::field<float>(&S::position_x, "position_x"),
+                           schema::field<float>(&S::position_y, "position_y"),
+                           schema::field<float>(&S::position_z, "position_z"));
   }
 
+  std::vector<float> values() { return {position_x, position_y, position_z}; }
+
   void update(Robot *robot) {
     Pose2D pose_odom = from_robot(robot->chassis.get_pose());
     position_x = pose_odom.x;
@@ -102,21 +102,22 @@ struct PositionSubject final : SubjectWithUID<0x00020009eeb7cece> {
   }
 };
 
-struct AttiInfoSubject : SubjectWithUID<0x000200096b986306> {
+struct AttiInfoSubject : SubjectWithSchema<0x000200096b986306, AttiInfoSubject> {
   std::string name() { return "AttiInfo"; }
   // degrees
   float yaw;
   float pitch;
   float roll;
 
-  std::vector<uint8_t> encode() {
-    std::vector<uint8_t> buffer(4 * 3, 0);
-    write<float>(buffer, 4 * 0, yaw);
-    write<float>(buffer, 4 * 1, pitch);
-    write<float>(buffer, 4 * 2, roll);
-    return buffer;
+  static constexpr auto fields() {
+    using S = AttiInfoSubject;
+    return std::make_tuple(schema::field<float>(&S::yaw, "yaw"),
+                           schema::field<float>(&S::pitch, "pitch"),
+                           schema::field<float>(&S::roll, "roll"));
   }
 
+  std::vector<float> values() { return {yaw, pitch, roll}; }
+
   void update(Robot *robot) {
     Attitude attitude_odom = from_robot(robot->chassis.get_attitude());
     yaw = attitude_odom.yaw;
@@ -125,7 +126,7 @@ struct AttiInfoSubject : SubjectWithUID<0x000200096b986306> {
   }
 };
 
-struct ChassisModeSubject : SubjectWithUID<0x000200094fcb1146> {
+struct ChassisModeSubject : SubjectWithSchema<0x000200094fcb1146, ChassisModeSubject> {
   std::string name() { return "ChassisMode"; }
   // ? not exposed/documented in the Python client library
   uint8_t mis_cur_type;
@@ -133,7 +134,11 @@ struct ChassisModeSubject : SubjectWithUID<0x000200094fcb1146> {
   // => NO: 8 when stopped, 5 when moving (with an action), ...
   uint8_t sdk_cur_type;
 
-  std::vector<uint8_t> encode() { return {mis_cur_type, sdk_cur_type}; }
+  static constexpr auto fields() {
+    using S = ChassisModeSubject;
+    return std::make_tuple(schema::field<uint8_t>(&S::mis_cur_type, "mis_cur_type"),
+                           schema::field<uint8_t>(&S::sdk_cur_type, "sdk_cur_type"));
+  }
 
   void update(Robot *robot) {
     sdk_cur_type = robot->get_mode();
@@ -141,7 +146,7 @@ struct ChassisModeSubject : SubjectWithUID<0x000200094fcb1146> {
   }
 };
 
-struct EscSubject : SubjectWithUID<0x00020009c14cb7c5> {
+struct EscSubject : SubjectWithSchema<0x00020009c14cb7c5, EscSubject> {
   std::string name() { return "Esc"; }
   constexpr static const int max_speed = 8191;
   constexpr static const int min_speed = -8192;
@@ -171,22 +176,19 @@ struct EscSubject : SubjectWithUID<0x00020009c14cb7c5> {
   // ?
   uint8_t state[4];
 
-  std::vector<uint8_t> encode() {
-    std::vector<uint8_t> buffer(4 * (2 + 2 + 4 + 1), 0);
-    size_t j = 0;
-    for (size_t i = 0; i < 4; i++, j += 2) {
-      write<int16_t>(buffer, j, speed[i]);
-    }
-    for (size_t i = 0; i < 4; i++, j += 2) {
-      write<int16_t>(buffer, j, angle[i]);
-    }
-    for (size_t i = 0; i < 4; i++, j += 4) {
-      write<uint32_t>(buffer, j, timestamp[i]);
-    }
-    for (size_t i = 0; i < 4; i++, j++) {
-      buffer[j] = state[i];
-    }
-    return buffer;
+  static constexpr auto fields() {
+    using S = EscSubject;
+    return std::make_tuple(schema::field<int16_t>(&S::speed, "speed"),
+                           schema::field<int16_t>(&S::angle, "angle"),
+                           schema::field<uint32_t>(&S::timestamp, "timestamp"),
+                           schema::field<uint8_t>(&S::state, "state"));
+  }
+
+  // Without the timestamps, which change at every step
+  std::vector<float> values() {
+    std::vector<float> value(speed, speed + 4);
+    value.insert(value.end(), angle, angle + 4);
+    return value;
   }
 
   void update(Robot *robot) {
@@ -212,7 +214,7 @@ struct EscSubject : SubjectWithUID<0x00020009c14cb7c5> {
   }
 };
 
-struct ImuSubject : SubjectWithUID<0x00020009a7985b8d> {
+struct ImuSubject : SubjectWithSchema<0x00020009a7985b8d, ImuSubject> {
   std::string name() { return "Imu"; }
   // [m/s^2]
   static constexpr float G = 9.81f;
@@ -223,17 +225,16 @@ struct ImuSubject : SubjectWithUID<0x00020009a7985b8d> {
   // angular velocity [deg/s]
   float gyro_x, gyro_y, gyro_z;
 
-  std::vector<uint8_t> encode() {
-    std::vector<uint8_t> buffer(4 * 6, 0);
-    write<float>(buffer, 4 * 0, acc_x);
-    write<float>(buffer, 4 * 1, acc_y);
-    write<float>(buffer, 4 * 2, acc_z);
-    write<float>(buffer, 4 * 3, gyro_x);
-    write<float>(buffer, 4 * 4, gyro_y);
-    write<float>(buffer, 4 * 5, gyro_z);
-    return buffer;
+  static constexpr auto fields() {
+    using S = ImuSubject;
+    return std::make_tuple(
+        schema::field<float>(&S::acc_x, "acc_x"), schema::field<float>(&S::acc_y, "acc_y"),
+        schema::field<float>(&S::acc_z, "acc_z"), schema::field<float>(&S::gyro_x, "gyro_x"),
+        schema::field<float>(&S::gyro_y, "gyro_y"), schema::field<float>(&S::gyro_z, "gyro_z"));
   }
 
+  std::vector<float> values() { return {acc_x, acc_y, acc_z, gyro_x, gyro_y, gyro_z}; }
+
   void update(Robot *robot) {
     IMU imu_body = robot->chassis.get_imu();
     acc_x = acc(imu_body.acceleration.x);
@@ -292,25 +293,25 @@ struct SaStatusSubject : SubjectWithUID<0x000200094a2c6d55> {
   }
 };
 
-struct SbusSubject : SubjectWithUID<0x0002000988223568> {
+struct SbusSubject : SubjectWithSchema<0x0002000988223568, SbusSubject> {
   std::string name() { return "Sbus"; }
   uint8_t connect_status;
   int16_t subs_channel[16];
 
-  std::vector<uint8_t> encode() {
-    uint8_t *b = reinterpret_cast<uint8_t *>(&subs_channel);
-    std::vector<uint8_t> buffer(b, b + 32);
-    buffer.insert(buffer.begin(), connect_status);
-    return buffer;
+  static constexpr auto fields() {
+    using S = SbusSubject;
+    return std::make_tuple(schema::field<uint8_t>(&S::connect_status, "connect_status"),
+                           schema::field<int16_t>(&S::subs_channel, "subs_channel"));
   }
 
   void update(Robot *robot) {
     // spdlog::warn("SbusSubject not implemented");
     connect_status = false;
+    std::fill(std::begin(subs_channel), std::end(subs_channel), 0);
   }
 };
 
-struct BatterySubject : SubjectWithUID<0x000200096862229f> {
+struct BatterySubject : SubjectWithSchema<0x000200096862229f, BatterySubject> {
   std::string name() { return "Battery"; }
 
   uint16_t adc_value;
@@ -318,14 +319,13 @@ struct BatterySubject : SubjectWithUID<0x000200096862229f> {
   int32_t current;
   uint8_t percent;
 
-  std::vector<uint8_t> encode() {
-    std::vector<uint8_t> buffer(10, 0);
-    write<uint16_t>(buffer, 0, adc_value);
-    write<int16_t>(buffer, 2, temperature);
-    write<int32_t>(buffer, 4, current);
-    write<uint8_t>(buffer, 8, percent);
-    buffer[9] = 1;
-    return buffer;
+  static constexpr auto fields() {
+    using S = BatterySubject;
+    return std::make_tuple(schema::field<uint16_t>(&S::adc_value, "adc_value"),
+                           schema::field<int16_t>(&S::temperature, "temperature"),
+                           schema::field<int32_t>(&S::current, "current"),
+                           schema::field<uint8_t>(&S::percent, "percent"),
+                           schema::constant<uint8_t>(1));
   }
 
   void update(Robot *robot) {
@@ -337,28 +337,31 @@ struct BatterySubject : SubjectWithUID<0x000200096862229f> {
   }
 };
 
-struct GripperSubject : SubjectWithUID<0x00020009124d156a> {
+struct GripperSubject : SubjectWithSchema<0x00020009124d156a, GripperSubject> {
   std::string name() { return "Gripper"; }
 
   uint8_t status;
 
-  std::vector<uint8_t> encode() { return {status}; }
+  static constexpr auto fields() {
+    return std::make_tuple(schema::field<uint8_t>(&GripperSubject::status, "status"));
+  }
 
   void update(Robot *robot) { status = robot->gripper.get_status(); }
 };
 
-struct ArmSubject : SubjectWithUID<0x0002000926abd64d> {
+struct ArmSubject : SubjectWithSchema<0x0002000926abd64d, ArmSubject> {
   std::string name() { return "Arm"; }
   // [mm], TODO(Jerome): check
   uint32_t pos_x, pos_y;
 
-  std::vector<uint8_t> encode() {
-    std::vector<uint8_t> buffer(9, 0);
-    write<uint32_t>(buffer, 1, pos_x);
-    write<uint32_t>(buffer, 5, pos_y);
-    return buffer;
+  static constexpr auto fields() {
+    using S = ArmSubject;
+    return std::make_tuple(schema::padding<1>(), schema::field<uint32_t>(&S::pos_x, "pos_x"),
+                           schema::field<uint32_t>(&S::pos_y, "pos_y"));
   }
 
+  std::vector<float> values() { return {float(pos_x), float(pos_y)}; }
+
   void update(Robot *robot) {
     Vector3 position = robot->arm.get_position();
     pos_x = static_cast<uint32_t>(1000 * position.x);
@@ -427,6 +430,8 @@ struct TofSubject : SubjectWithUID<0x0002000986e4c05a> {
     return buffer;
   }
 
+  std::vector<float> values() { return std::vector<float>(distance, distance + NUMBER_OF_TOF); }
+
   void update(Robot *robot) {
     auto readings = robot->get_tof_readings();
     for (size_t i = 0; i < std::min(NUMBER_OF_TOF, readings.size()); i++) {
@@ -467,6 +472,11 @@ struct GimbalPosSubject : SubjectWithUID<0x00020009f79b3c97> {
     return buffer;
   }
 
+  std::vector<float> values() {
+    return {float(yaw_ground_angle), float(pitch_ground_angle), float(yaw_angle),
+            float(pitch_angle)};
+  }
+
   void update(Robot *robot) {
     auto attitude = robot->gimbal.attitude(Gimbal::Frame::chassis);
     yaw_angle = -round(rad2deg(10 * attitude.yaw));
@@ -502,6 +512,16 @@ struct AdapterSubject : SubjectWithUID<0x00020009eebb9ffc> {
   }
 };
 
-
+// The payload sizes expected by the clients
+static_assert(VelocitySubject::size() == 24);
+static_assert(PositionSubject::size() == 12);
+static_assert(AttiInfoSubject::size() == 12);
+static_assert(ChassisModeSubject::size() == 2);
+static_assert(EscSubject::size() == 36);
+static_assert(ImuSubject::size() == 24);
+static_assert(SbusSubject::size() == 33);
+static_assert(BatterySubject::size() == 10);
+static_assert(GripperSubject::size() == 1);
+static_assert(ArmSubject::size() == 9);
 
 #endif  // INCLUDE_COMMAND_SUBJECTS_HPP_
@@ -6,23 +6,25 @@
 
 #include <boost/asio.hpp>
 
+#include "scheduler.hpp"
+
 namespace ba = boost::asio;
 
 using ba::ip::udp;
 
 class Discovery {
  public:
-  Discovery(boost::asio::io_context *io_context, std::string serial_number, std::string ip = "",
-            unsigned prefix_len = 0, float period = 1.0, const std::string app_id = "");
+  Discovery(boost::asio::io_context *io_context, Scheduler *scheduler, std::string serial_number,
+            std::string ip = "", unsigned prefix_len = 0, float period = 1.0,
+            const std::string app_id = "");
   void start();
   void stop();
-  void do_step(float time_step);
 
  private:
   udp::socket socket;
+  Scheduler *scheduler;
   float period;
-  bool active;
-  float deadline;
+  Scheduler::TimerPtr timer;
   unsigned port;
   std::string message;
   unsigned sta_conn_info_port;
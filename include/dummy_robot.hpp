@@ -22,9 +22,7 @@ class DummyRobot : public Robot {
   Gripper::Status read_gripper_state() const;
   void forward_target_gripper(Gripper::Status state, float power);
   bool forward_camera_resolution(unsigned width, unsigned height);
-  Image read_camera_image() const;
-  hit_event_t read_hit_events() const;
-  ir_event_t read_ir_events() const;
+  bool read_camera_image(CameraFrame *frame) const;
   DetectedObjects read_detected_objects() const;
   void forward_target_servo_angle(size_t index, float angle);
   void forward_target_servo_speed(size_t index, float speed);
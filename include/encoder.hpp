@@ -4,6 +4,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <memory>
+#include <string>
 #include <vector>
 
 extern "C" {
@@ -12,6 +14,8 @@ extern "C" {
 #include "libavutil/imgutils.h"
 }
 
+#include "robot/frame_pool.hpp"
+
 // DONE:
 // - [x] add [TCP] socket
 // - [x] add RGB pixel interface (input to the decoder) (look at
@@ -21,24 +25,133 @@ extern "C" {
 // ---> perché devo anche scalare!!! (da 720p a 360p o 540p)
 // non needed as libx264 accept RGB
 // - [x] add dummy image feeder (timer) just to test the communication
-// - [x] should this be in a separate thread? -> no
+// - [x] should this be in a separate thread? -> yes, see `VideoStreamer`
 
-class Encoder {
+// An encoded frame. It references the output of the encoder without copying it and keeps it
+// alive until released, e.g., when the last socket write completes.
+class Packet {
  public:
-  explicit Encoder(unsigned bitrate = 400000, unsigned width = 1280, unsigned height = 720,
-                   int fps = 25);
+  virtual ~Packet() {}
+  virtual const uint8_t *data() const = 0;
+  virtual size_t size() const = 0;
+  // Whether a decoder can start from this packet
+  virtual bool is_keyframe() const = 0;
+};
 
-  std::vector<uint8_t> encode(uint8_t *buffer);
+using PacketPtr = std::shared_ptr<const Packet>;
+
+// Takes the reference of an AVPacket, i.e., the buffer that libavcodec allocated
+class AVPacketRef final : public Packet {
+ public:
+  explicit AVPacketRef(AVPacket *packet);
+  ~AVPacketRef();
+  AVPacketRef(const AVPacketRef &) = delete;
+  AVPacketRef &operator=(const AVPacketRef &) = delete;
+  const uint8_t *data() const override { return packet->data; }
+  size_t size() const override { return packet->size; }
+  bool is_keyframe() const override { return packet->flags & AV_PKT_FLAG_KEY; }
 
-  ~Encoder();
+ private:
+  AVPacket *packet;
+};
+
+// A camera frame sent as it is
+class FramePacket final : public Packet {
+ public:
+  explicit FramePacket(FramePtr frame)
+      : frame(std::move(frame)) {}
+  const uint8_t *data() const override { return frame->data(); }
+  size_t size() const override { return frame->size(); }
+  bool is_keyframe() const override { return true; }
 
  private:
+  FramePtr frame;
+};
+
+// Encodes the RGB24 frames of the camera for the video stream
+class Encoder {
+ public:
+  // - x264: H.264, like the real robot (see `Format` and `Profile`)
+  // - mjpeg: independent JPEG images, cheaper to encode than H.264 but larger
+  // - raw: the RGB24 frames as they are, for clients on the same host
+  enum Backend { x264 = 0, mjpeg = 1, raw = 2 };
+  // The pixel format of the encoded stream; input frames are always RGB24.
+  // - rgb24: 4:4:4 RGB with libx264rgb
+  // - yuv420p: 4:2:0 YUV with libx264, like the real robot, converting frames first
+  enum Format { rgb24 = 0, yuv420p = 1 };
+  // - standard: an IDR frame every 10 frames, B-frames
+  // - low_latency: no B-frames, a periodic intra refresh instead of IDR frames, a VBV of one frame
+  //   and slices that fit in a network packet
+  enum Profile { standard = 0, low_latency = 1 };
+
+  // `format` and `profile` apply to x264 only
+  static std::unique_ptr<Encoder> create(Backend backend, unsigned bitrate, unsigned width,
+                                         unsigned height, int fps, Format format = rgb24,
+                                         Profile profile = standard);
+
+  virtual ~Encoder() {}
+  // Returns nullptr if the encoder has no output (yet)
+  virtual PacketPtr encode(const FramePtr &frame) = 0;
+  // Changes the target bitrate of the next frames [bits/s].
+  // Returns false if the encoder does not support it, i.e., if it has to be created again.
+  virtual bool set_bitrate(unsigned bitrate) { return false; }
+};
+
+// Parses "x264", "mjpeg" or "raw"
+inline bool encoder_backend_from_string(const std::string &value, Encoder::Backend *backend) {
+  if (value == "x264") {
+    *backend = Encoder::x264;
+  } else if (value == "mjpeg") {
+    *backend = Encoder::mjpeg;
+  } else if (value == "raw") {
+    *backend = Encoder::raw;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// The common part of the encoders based on libavcodec
+class LibAVEncoder : public Encoder {
+ public:
+  ~LibAVEncoder();
+  PacketPtr encode(const FramePtr &frame) override;
+
+ protected:
+  // Allocates the codec context, to be configured before calling `open`
+  LibAVEncoder(const char *codec_name, unsigned bitrate, unsigned width, unsigned height, int fps,
+               AVPixelFormat pix_fmt);
+  void open();
+
   const AVCodec *codec;
   AVCodecContext *c;
+
+ private:
   AVFrame *frame;
   AVPacket *pkt;
   int seq;
   bool ready;
 };
 
+class H264Encoder final : public LibAVEncoder {
+ public:
+  explicit H264Encoder(unsigned bitrate = 400000, unsigned width = 1280, unsigned height = 720,
+                       int fps = 25, Format format = rgb24, Profile profile = standard);
+  bool set_bitrate(unsigned bitrate) override;
+};
+
+class MJPEGEncoder final : public LibAVEncoder {
+ public:
+  explicit MJPEGEncoder(unsigned bitrate = 4000000, unsigned width = 1280, unsigned height = 720,
+                        int fps = 25);
+};
+
+class RawEncoder final : public Encoder {
+ public:
+  RawEncoder(unsigned width, unsigned height);
+  PacketPtr encode(const FramePtr &frame) override;
+  // Not compressed: the bitrate does not apply
+  bool set_bitrate(unsigned bitrate) override { return true; }
+};
+
 #endif  // INCLUDE_ENCODER_HPP_
@@ -6,29 +6,52 @@
 #include <vector>
 
 #include "command.hpp"
+#include "event_ring.hpp"
 #include "protocol.hpp"
 #include "robot/robot.hpp"
 
-template <typename B> struct Event {
+// Pushes a message of type `B` for each event popped from `ring`, of which it is the only
+// consumer. Events pushed before this is created, e.g., when no client had subscribed yet,
+// are stale: they are discarded.
+template <typename B, typename T, size_t N> struct Event {
   Commands *cmd;
-  Robot *robot;
+  EventRing<T, N> *ring;
   uint8_t sender;
   uint8_t receiver;
+  uint64_t overflows;
+  std::vector<uint8_t> message;
 
-  Event(Commands *cmd, Robot *robot, uint8_t sender, uint8_t receiver)
+  Event(Commands *cmd, EventRing<T, N> *ring, uint8_t sender, uint8_t receiver)
       : cmd(cmd)
-      , robot(robot)
+      , ring(ring)
       , sender(sender)
-      , receiver(receiver) {}
+      , receiver(receiver)
+      , overflows(0)
+      , message() {
+    T event;
+    while (ring->pop(&event)) {
+    }
+    overflows = ring->overflows();
+  }
 
   void do_step(float time_step) {
-    for (auto &msg : update_msg()) {
-      auto data = msg.encode_msg(B::set, B::cmd);
-      spdlog::debug("Push Event Msg {} bytes: {:n}", data.size(), spdlog::to_hex(data));
-      cmd->send(data);
+    const uint64_t value = ring->overflows();
+    if (value != overflows) {
+      spdlog::warn("[Event] Lost {} events of type {:#x}:{:#x}: the ring is full",
+                   value - overflows, B::set, B::cmd);
+      overflows = value;
+    }
+    T event;
+    uint64_t sequence_number;
+    while (ring->pop(&event, &sequence_number)) {
+      auto msg = response(event);
+      msg.encode_msg(B::set, B::cmd, msg.encode(), &message);
+      spdlog::debug("Push Event Msg #{} {} bytes: {:n}", sequence_number, message.size(),
+                    spdlog::to_hex(message));
+      cmd->send(message);
     }
   }
-  virtual std::vector<typename B::Response> update_msg() = 0;
+  virtual typename B::Response response(const T &event) = 0;
   virtual ~Event() {}
 };
 
@@ -67,66 +90,104 @@ void encode(std::vector<uint8_t> &buffer, size_t location, const DetectedObjects
 }
 
 struct VisionDetectInfo : Proto<0xa, 0xa4> {
+  // Reused at each step: the buffer keeps its storage
   struct Response : ResponseT {
-    Response(uint8_t sender, uint8_t receiver, uint16_t type, uint8_t number)
+    Response(uint8_t sender, uint8_t receiver, uint8_t type)
         : ResponseT(sender, receiver)
         , type(type)
-        , number(number)
         , status(0)
         , errcode(0)
-        , buffer(20 * number + 9) {}
+        , buffer() {}
 
     uint8_t type;
-    uint8_t number;
     uint8_t status;
     uint16_t errcode;
+    // 9 bytes of header, then 20 bytes per object
     std::vector<uint8_t> buffer;
 
-    std::vector<uint8_t> encode() {
+    template <typename T> void set_objects(const std::vector<T> &objects) {
+      buffer.assign(20 * objects.size() + 9, 0);
       buffer[0] = type;
       buffer[1] = status;
       write<uint16_t>(buffer, 6, errcode);
-      buffer[8] = number;
-      // buffer is encoded externally to get around polymorphic items
-      return buffer;
+      buffer[8] = objects.size();
+      size_t location = 9;
+      for (const auto &object : objects) {
+        ::encode(buffer, location, object);
+        location += 20;
+      }
     }
+
+    std::vector<uint8_t> encode() { return buffer; }
   };
 };
 
-struct VisionEvent : Event<VisionDetectInfo> {
-  VisionEvent(Commands *cmd, Robot *robot, uint8_t sender, uint8_t receiver, uint8_t type)
-      : Event(cmd, robot, sender, receiver)
-      , type(type) {}
-
-  template <typename T>
-  void add_message(std::vector<VisionDetectInfo::Response> &msgs, const DetectedObjects &objects) {
-    if (type & (1 << T::type)) {
-      auto items = objects.get<T>();
-      auto size = items.size();
-      if (size) {
-        VisionDetectInfo::Response msg(sender, receiver, T::type, size);
-        size_t location = 9;
-        for (auto &item : items) {
-          encode(msg.buffer, location, item);
-          location += 20;
-        }
-        msgs.push_back(msg);
-      }
+// Pushes the detected objects of the enabled types at each step, one message per type.
+// Unlike the other events, it encodes in place, as there may be dozens of objects per step.
+struct VisionEvent {
+  struct Channel {
+    VisionDetectInfo::Response response;
+    // The payload of the last push, empty if nothing was pushed at the last step
+    std::vector<uint8_t> last_payload;
+    std::vector<uint8_t> message;
+
+    Channel(uint8_t sender, uint8_t receiver, uint8_t type)
+        : response(sender, receiver, type)
+        , last_payload()
+        , message() {}
+  };
+
+  Commands *cmd;
+  Robot *robot;
+  uint8_t type;
+  // Skip pushes of objects that did not change since the last step
+  bool only_on_change;
+  Channel people;
+  Channel gestures;
+  Channel lines;
+  Channel markers;
+  Channel robots;
+
+  VisionEvent(Commands *cmd, Robot *robot, uint8_t sender, uint8_t receiver, uint8_t type,
+              bool only_on_change = false)
+      : cmd(cmd)
+      , robot(robot)
+      , type(type)
+      , only_on_change(only_on_change)
+      , people(sender, receiver, DetectedObjects::PERSON)
+      , gestures(sender, receiver, DetectedObjects::GESTURE)
+      , lines(sender, receiver, DetectedObjects::LINE)
+      , markers(sender, receiver, DetectedObjects::MARKER)
+      , robots(sender, receiver, DetectedObjects::ROBOT) {}
+
+  template <typename T> void push(const std::vector<T> &objects, Channel *channel) {
+    if (!(type & (1 << T::type)))
+      return;
+    if (objects.empty()) {
+      channel->last_payload.clear();
+      return;
     }
+    auto &payload = channel->response.buffer;
+    channel->response.set_objects(objects);
+    if (only_on_change && payload == channel->last_payload)
+      return;
+    channel->response.encode_msg(VisionDetectInfo::set, VisionDetectInfo::cmd, payload,
+                                 &channel->message);
+    spdlog::debug("Push Event Msg {} bytes: {:n}", channel->message.size(),
+                  spdlog::to_hex(channel->message));
+    cmd->send(channel->message);
+    // The next `set_objects` reuses the storage of the previous payload
+    std::swap(payload, channel->last_payload);
   }
 
-  std::vector<VisionDetectInfo::Response> update_msg() {
-    auto objects = robot->vision.get_detected_objects();
-    std::vector<VisionDetectInfo::Response> msgs;
-    add_message<DetectedObjects::Person>(msgs, objects);
-    add_message<DetectedObjects::Gesture>(msgs, objects);
-    add_message<DetectedObjects::Line>(msgs, objects);
-    add_message<DetectedObjects::Marker>(msgs, objects);
-    add_message<DetectedObjects::Robot>(msgs, objects);
-    return msgs;
+  void do_step(float time_step) {
+    const DetectedObjects &objects = robot->vision.get_detected_objects();
+    push(objects.people, &people);
+    push(objects.gestures, &gestures);
+    push(objects.lines, &lines);
+    push(objects.markers, &markers);
+    push(objects.robots, &robots);
   }
-
-  uint8_t type;
 };
 
 struct ArmorHitEventMsg : Proto<0x3f, 0x02> {
@@ -154,20 +215,13 @@ struct ArmorHitEventMsg : Proto<0x3f, 0x02> {
   };
 };
 
-struct ArmorHitEvent : Event<ArmorHitEventMsg> {
+struct ArmorHitEvent : Event<ArmorHitEventMsg, HitEvent, 64> {
   ArmorHitEvent(Commands *cmd, Robot *robot, uint8_t sender = 0xc9, uint8_t receiver = 0x38)
-      : Event(cmd, robot, sender, receiver) {}
+      : Event(cmd, &robot->armor.hit_events, sender, receiver) {}
 
-  std::vector<ArmorHitEventMsg::Response> update_msg() {
-    auto hits = robot->armor.get_hit_events();
-    std::vector<ArmorHitEventMsg::Response> msgs;
-    for (auto const &hit : hits) {
-      msgs.emplace_back(sender, receiver, hit.type, hit.index, 0, 0);
-    }
-    return msgs;
+  ArmorHitEventMsg::Response response(const HitEvent &hit) {
+    return ArmorHitEventMsg::Response(sender, receiver, hit.type, hit.index, 0, 0);
   }
-
-  uint8_t type;
 };
 
 struct IRHitEventMsg : Proto<0x3f, 0x10> {
@@ -192,20 +246,14 @@ struct IRHitEventMsg : Proto<0x3f, 0x10> {
   };
 };
 
-struct IRHitEvent : Event<IRHitEventMsg> {
+struct IRHitEvent : Event<IRHitEventMsg, RobotIREvent, 64> {
   IRHitEvent(Commands *cmd, Robot *robot, uint8_t sender = 0xc9, uint8_t receiver = 0x38)
-      : Event(cmd, robot, sender, receiver) {}
+      : Event(cmd, &robot->armor.ir_events, sender, receiver) {}
 
-  std::vector<IRHitEventMsg::Response> update_msg() {
-    auto hits = robot->armor.get_ir_events();
-    std::vector<IRHitEventMsg::Response> msgs;
-    for (auto const &hit : hits) {
-      msgs.emplace_back(sender, receiver, hit.skill_id, hit.role_id, hit.recv_dev, hit.recv_ir_pin);
-    }
-    return msgs;
+  IRHitEventMsg::Response response(const RobotIREvent &hit) {
+    return IRHitEventMsg::Response(sender, receiver, hit.skill_id, hit.role_id, hit.recv_dev,
+                                   hit.recv_ir_pin);
   }
-
-  uint8_t type;
 };
 
 struct UARTMessage : Proto<0x3f, 0xc1> {
@@ -227,14 +275,12 @@ struct UARTMessage : Proto<0x3f, 0xc1> {
   };
 };
 
-struct UARTEvent : Event<UARTMessage> {
+struct UARTEvent : Event<UARTMessage, UARTData, 16> {
   UARTEvent(Commands *cmd, Robot *robot, uint8_t sender = 0xc9, uint8_t receiver = 0x66)
-      : Event(cmd, robot, sender, receiver) {}
+      : Event(cmd, &robot->uart.received, sender, receiver) {}
 
-  std::vector<UARTMessage::Response> update_msg() {
-    std::vector<UARTMessage::Response> msgs;
-    msgs.emplace_back(sender, receiver, 5, (const uint8_t *)"Hello");
-    return msgs;
+  UARTMessage::Response response(const UARTData &data) {
+    return UARTMessage::Response(sender, receiver, data.length, data.data);
   }
 };
 
@@ -0,0 +1,92 @@
+#ifndef INCLUDE_EVENT_RING_HPP_
+#define INCLUDE_EVENT_RING_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// A bounded, lock-free queue of events with multiple producers (e.g., backend callbacks,
+// from any thread) and a single consumer (the pusher of the event).
+//
+// Each event gets a sequence number when it is pushed. When the ring is full, new events are
+// dropped and counted as overflows, so that the consumer gets each event exactly once and
+// sequence numbers have no gaps. It never allocates: events must be trivially copyable.
+//
+// Adapted from D. Vyukov's bounded MPMC queue: each cell has its own sequence, which tells
+// whether it is free (`sequence == position`) or holds the event at `position`
+// (`sequence == position + 1`).
+template <typename T, size_t N> class EventRing {
+  static_assert(N && (N & (N - 1)) == 0, "The size of the ring must be a power of 2");
+  static_assert(std::is_trivially_copyable_v<T>, "Events must be trivially copyable");
+
+ public:
+  EventRing()
+      : cells()
+      , head(0)
+      , tail(0)
+      , overflows_(0) {
+    for (size_t i = 0; i < N; i++) {
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  EventRing(const EventRing &) = delete;
+  EventRing &operator=(const EventRing &) = delete;
+
+  // Returns false if the ring is full
+  bool push(const T &event) {
+    uint64_t position = head.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell &cell = cells[position & mask];
+      const uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+      const int64_t diff = static_cast<int64_t>(sequence - position);
+      if (diff == 0) {
+        if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        overflows_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      } else {
+        position = head.load(std::memory_order_relaxed);
+      }
+    }
+    Cell &cell = cells[position & mask];
+    cell.event = event;
+    cell.sequence.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only. Returns false if the ring is empty.
+  bool pop(T *event, uint64_t *sequence_number = nullptr) {
+    Cell &cell = cells[tail & mask];
+    if (cell.sequence.load(std::memory_order_acquire) != tail + 1)
+      return false;
+    *event = cell.event;
+    if (sequence_number)
+      *sequence_number = tail;
+    cell.sequence.store(tail + N, std::memory_order_release);
+    tail++;
+    return true;
+  }
+
+  // The number of events dropped because the ring was full
+  uint64_t overflows() const { return overflows_.load(std::memory_order_relaxed); }
+
+ private:
+  static constexpr uint64_t mask = N - 1;
+
+  struct Cell {
+    std::atomic<uint64_t> sequence;
+    T event;
+  };
+
+  std::array<Cell, N> cells;
+  // Producers and consumer update different lines
+  alignas(64) std::atomic<uint64_t> head;
+  alignas(64) uint64_t tail;
+  std::atomic<uint64_t> overflows_;
+};
+
+#endif  // INCLUDE_EVENT_RING_HPP_
@@ -61,6 +61,9 @@ struct ResponseT {
   virtual ~ResponseT() {}
 
   std::vector<uint8_t> encode_msg(uint8_t set, uint8_t id);
+  // Encode a message with `payload` (instead of `encode()`) into `buffer`, reusing its storage
+  void encode_msg(uint8_t set, uint8_t id, const std::vector<uint8_t> &payload,
+                  std::vector<uint8_t> *buffer);
 };
 
 template <uint8_t _set, uint8_t _cmd> struct Proto {
@@ -13,6 +13,7 @@
 #include "connection.hpp"
 #include "discovery.hpp"
 #include "robot/robot.hpp"
+#include "scheduler.hpp"
 #include "streamer.hpp"
 
 class RoboMaster {
@@ -37,10 +38,39 @@ class RoboMaster {
     }
   }
   VideoStreamer *get_video_streamer() { return video.get(); }
+  // Shared by all periodic pushes (topics, actions, discovery)
+  Scheduler *get_scheduler() { return &scheduler; }
+  // Publish new topics on wall-clock timers from the IO thread instead of in simulation time
+  void set_real_time_topics(bool value) { cmds.set_real_time_topics(value); }
+  void set_vision_on_change(bool value) { cmds.set_vision_on_change(value); }
+  // Applies to the next video stream
+  void set_video_encoder(Encoder::Backend value) { video->set_encoder(value); }
+  void set_adaptive_video_bitrate(unsigned min_bitrate, unsigned max_bitrate) {
+    video->set_adaptive_bitrate(min_bitrate, max_bitrate);
+  }
+  // Of the current (or last) video stream
+  VideoStats get_video_stats() { return video->get_stats(); }
+  // Set when topics push a subject (or all subjects if `subject` is empty)
+  bool set_publish_policy(const std::string &subject, const PublishPolicy &policy) {
+    return cmds.set_publish_policy(subject, policy);
+  }
+  bool set_priority(const std::string &subject, float priority) {
+    return cmds.set_priority(subject, priority);
+  }
+  // [bytes/s], 0 for no limit
+  void set_bandwidth_budget(float value) { cmds.set_bandwidth_budget(value); }
+  std::vector<TopicReport> get_topic_stats() { return cmds.get_topic_stats(); }
+  void dump_topic_stats() { cmds.dump_topic_stats(); }
+  // Feed a datagram addressed to `port` to the corresponding server, bypassing the socket.
+  // Returns false if no server listens on that port.
+  bool inject(unsigned short port, const uint8_t *buffer, size_t length,
+              const udp::endpoint &sender);
 
  private:
   std::shared_ptr<boost::asio::io_context> io_context;
   Robot *robot;
+  // Declared before its users, so that it outlives them
+  Scheduler scheduler;
   Discovery discovery;
   Connection conn;
   Commands cmds;
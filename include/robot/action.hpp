@@ -2,6 +2,7 @@
 #define INCLUDE_ROBOT_ACTION_HPP_
 
 #include <algorithm>
+#include <string>
 
 #include "../utils.hpp"
 #include "gimbal.hpp"
@@ -11,6 +12,11 @@ class Robot;
 using Callback = std::function<void(float)>;
 
 struct Action {
+  // Robot has one slot per kind: at most one action of each kind runs at the same time.
+  // The values + 1 are the action handles of the Lua API.
+  enum Kind : uint8_t { MOVE = 0, MOVE_ARM = 1, MOVE_GIMBAL = 2, PLAY_SOUND = 3, MOVE_SERVO = 4 };
+  static constexpr size_t number_of_kinds = 5;
+
   enum State : uint8_t {
     running = 0,
     succeed = 1,
@@ -18,10 +24,22 @@ struct Action {
     started = 3,
     undefined = 4,
     rejected = 5,
+    // Waiting for the running action of the same kind to finish (not a state of the protocol)
+    queued = 6,
+  };
+  // What to do with a new action while another of the same kind is running
+  enum Policy : uint8_t {
+    reject = 0,
+    // Start it after the queued actions, when the running one is done
+    queue = 1,
+    // Abort (`failed`) the running and the queued actions and start it now
+    preempt = 2,
   };
   explicit Action(Robot *robot)
       : robot(robot)
       , state(State::undefined)
+      , predicted_duration(0.0f)
+      , remaining_duration(0.0f)
       , callback([](float) {}) {}
   virtual void do_step(float time_step) = 0;
   void do_step_cb(float time_step) {
@@ -30,37 +48,85 @@ struct Action {
   }
   virtual ~Action() {}
   bool done() { return state == Action::State::failed || state == Action::State::succeed; }
+  // The progress in [0, 100], from the durations once the action is running
+  uint8_t percent() const {
+    if (state == Action::State::succeed)
+      return 100;
+    if (state != Action::State::running && state != Action::State::failed)
+      return 0;
+    if (predicted_duration <= 0)
+      return 0;
+    const int value = 100 - round(100.0f * remaining_duration / predicted_duration);
+    return std::clamp(value, 0, 100);
+  }
   void set_callback(Callback value) { callback = value; }
+  // Change the state from outside of `do_step` (e.g., when preempted) and notify the callback
+  void set_state(State value) {
+    state = value;
+    callback(0.0f);
+  }
 
   Robot *robot;
   State state;
   float predicted_duration;
   float remaining_duration;
+  // Called after each step and when the state is changed by `set_state`
   Callback callback;
 };
 
-inline float time_to_goal(const Pose2D &goal_pose, float linear_speed, float angular_speed) {
-  return std::max(std::abs(normalize(goal_pose.theta)) / angular_speed,
-                  goal_pose.distance() / linear_speed);
+inline bool action_policy_from_string(const std::string &value, Action::Policy *policy) {
+  if (value == "reject") {
+    *policy = Action::Policy::reject;
+  } else if (value == "queue") {
+    *policy = Action::Policy::queue;
+  } else if (value == "preempt") {
+    *policy = Action::Policy::preempt;
+  } else {
+    return false;
+  }
+  return true;
 }
 
+// A motion from 0 to 1 with constant acceleration up to `max_speed`, constant speed,
+// then constant deceleration; a triangle if it is too short to reach `max_speed`.
+struct TrapezoidalProfile {
+  TrapezoidalProfile(float max_speed = 1.0f, float acceleration = 1.0f);
+  // [s]
+  float duration;
+  // In [0, 1], constant outside of [0, duration]
+  float position(float time) const;
+
+ private:
+  float max_speed;
+  float acceleration;
+  float ramp_duration;
+};
+
+// Moves along the line to the goal while rotating, following the same trapezoidal profile
+// scaled to the linear and angular distances, so that both end at the same time.
 struct MoveAction : Action {
-  MoveAction(Robot *robot, Pose2D goal_pose, float _linear_speed, float _angular_speed)
-      : Action(robot)
-      , goal(goal_pose)
-      , linear_speed(_linear_speed)
-      , angular_speed(_angular_speed) {
-    predicted_duration = time_to_goal(goal_pose, linear_speed, angular_speed);
-  }
+  static constexpr Kind kind{MOVE};
+  // [m/s^2]
+  static constexpr float linear_acceleration = 1.0f;
+  // [rad/s^2]
+  static constexpr float angular_acceleration = 3.0f;
+  // [1/s] to correct the deviations from the profile
+  static constexpr float gain = 2.0f;
+
+  MoveAction(Robot *robot, Pose2D goal_pose, float _linear_speed, float _angular_speed);
   virtual void do_step(float time_step);
+  // in the frame of the robot at the start
   Pose2D goal;
-  Pose2D goal_odom;
-  Pose2D current;
+  // [[odom]]
+  Pose2D start;
   float linear_speed;
   float angular_speed;
+  TrapezoidalProfile profile;
+  float elapsed;
 };
 
 struct MoveArmAction : Action {
+  static constexpr Kind kind{MOVE_ARM};
   MoveArmAction(Robot *robot, float x, float z, bool _absolute)
       : Action(robot)
       , goal_position({x, 0, z})
@@ -73,6 +139,7 @@ struct MoveArmAction : Action {
 };
 
 struct PlaySoundAction : Action {
+  static constexpr Kind kind{PLAY_SOUND};
   static constexpr float duration = 3.0;
 
   PlaySoundAction(Robot *robot, uint32_t _sound_id, uint8_t _play_times)
@@ -88,6 +155,7 @@ struct PlaySoundAction : Action {
 };
 
 struct MoveServoAction : Action {
+  static constexpr Kind kind{MOVE_SERVO};
   static constexpr float MAX_DURATION = 5.0;
   MoveServoAction(Robot *robot, size_t servo_id, float target_angle)
       : Action(robot)
@@ -102,6 +170,7 @@ struct MoveServoAction : Action {
 };
 
 struct MoveGimbalAction : Action {
+  static constexpr Kind kind{MOVE_GIMBAL};
   MoveGimbalAction(Robot *robot, float target_yaw, float target_pitch, float yaw_speed,
                    float pitch_speed, Gimbal::Frame yaw_frame, Gimbal::Frame pitch_frame)
       : Action(robot)
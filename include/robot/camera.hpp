@@ -1,18 +1,17 @@
 #ifndef INCLUDE_ROBOT_CAMERA_HPP_
 #define INCLUDE_ROBOT_CAMERA_HPP_
 
-#include <vector>
-
 #include "../utils.hpp"
-
-using Image = std::vector<uint8_t>;
+#include "frame_pool.hpp"
 
 struct Camera {
   int width;
   int height;
   float fps;
   bool streaming;
-  Image image;
+  // The last captured frame, if any
+  FramePtr image;
+  FramePool pool;
   Camera()
       : streaming(false) {}
 };
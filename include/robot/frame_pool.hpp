@@ -0,0 +1,63 @@
+#ifndef INCLUDE_ROBOT_FRAME_POOL_HPP_
+#define INCLUDE_ROBOT_FRAME_POOL_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// An RGB24 camera image in a buffer owned by a `FramePool`
+class CameraFrame {
+ public:
+  static constexpr size_t alignment = 64;
+
+  CameraFrame();
+  ~CameraFrame();
+  CameraFrame(const CameraFrame &) = delete;
+  CameraFrame &operator=(const CameraFrame &) = delete;
+
+  uint8_t *data() { return buffer; }
+  const uint8_t *data() const { return buffer; }
+  // [bytes]
+  size_t size() const { return 3 * width * height; }
+
+  unsigned width;
+  unsigned height;
+
+ private:
+  friend class FramePool;
+  uint8_t *buffer;
+  size_t capacity;
+  // Reallocates only if the buffer is too small
+  void resize(unsigned width, unsigned height);
+};
+
+// Shared by the users of a frame (e.g., the camera and the video encoder): the frame goes back
+// to the pool when the last reference is released.
+using FramePtr = std::shared_ptr<CameraFrame>;
+
+// Recycled frames, so that capturing an image does not allocate nor copy it again: frames are
+// allocated on the first leases, then reused. Frames can be released from any thread.
+class FramePool {
+ public:
+  explicit FramePool(size_t max_number_of_frames = 6);
+
+  // Returns a frame of `width` x `height` pixels (with undefined content),
+  // or nullptr if all frames are in use.
+  FramePtr lease(unsigned width, unsigned height);
+  size_t leased() const;
+
+ private:
+  // Outlives the pool while frames are leased
+  struct Storage {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<CameraFrame>> free_frames;
+    size_t number_of_frames;
+    size_t leased;
+  };
+  std::shared_ptr<Storage> storage;
+  size_t max_number_of_frames;
+};
+
+#endif  // INCLUDE_ROBOT_FRAME_POOL_HPP_
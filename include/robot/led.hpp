@@ -2,7 +2,7 @@
 #define INCLUDE_ROBOT_LED_HPP_
 
 #include <algorithm>
-#include <map>
+#include <array>
 
 #include "../utils.hpp"
 
@@ -76,10 +76,7 @@ class CompositeLED : public ActiveLED {
               CompositeLedMask mask);
   Color get_color(size_t index) {
     if (effect == LedEffect::on || effect == LedEffect::off) {
-      if (colors.count(index)) {
-        return colors[index];
-      }
-      return {};
+      return colors[index];
     }
     return color;
   }
@@ -89,9 +86,11 @@ class CompositeLED : public ActiveLED {
     return value;
   }
   size_t number;
+  static constexpr size_t max_number = 8;
 
  private:
-  std::map<size_t, Color> colors;
+  // Black if not set
+  std::array<Color, max_number> colors;
 };
 
 struct ChassisLED : ChassisLEDValues<ActiveLED> {
@@ -6,8 +6,10 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <deque>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -29,6 +31,7 @@
 #include "led.hpp"
 #include "servo.hpp"
 #include "tof.hpp"
+#include "uart.hpp"
 #include "vision.hpp"
 
 // 3 EP servos + 2 S1 gimbal servos
@@ -57,9 +60,8 @@ class Robot {
   virtual Gripper::Status read_gripper_state() const = 0;
   virtual void forward_target_gripper(Gripper::Status state, float power) = 0;
   virtual bool forward_camera_resolution(unsigned width, unsigned height) = 0;
-  virtual Image read_camera_image() const = 0;
-  virtual hit_event_t read_hit_events() const = 0;
-  virtual ir_event_t read_ir_events() const = 0;
+  // Fill `frame`, sized to the camera resolution. Returns false if there is no image.
+  virtual bool read_camera_image(CameraFrame *frame) const = 0;
   virtual DetectedObjects read_detected_objects() const = 0;
   virtual void forward_target_servo_angle(size_t index, float angle) = 0;
   virtual void forward_target_servo_speed(size_t index, float speed) = 0;
@@ -178,23 +180,22 @@ class Robot {
   GimbalLED gimbal_leds;
   Gripper gripper;
   ToF tof;
+  UART uart;
   Vision vision;
 
-  Action *get_action(std::string name) {
-    if (actions.count(name)) {
-      return actions[name].get();
-    }
-    return nullptr;
-  }
+  Action *get_action(Action::Kind kind) { return actions[kind].get(); }
 
-  Action::State get_action_state(std::string name) {
-    if (actions.count(name)) {
-      return actions[name]->state;
-    }
-    if (previous_action_state.count(name)) {
-      return previous_action_state[name];
+  // Set what happens to actions submitted while another of the same kind is running:
+  // with `queue`, at most `max_queue_length` actions wait (default: reject them all).
+  void set_action_policy(Action::Kind kind, Action::Policy policy, size_t max_queue_length = 8);
+
+  // The state of the running action of this kind, else of the last one
+  Action::State get_action_state(Action::Kind kind) {
+    std::lock_guard<std::mutex> lock(action_mutex);
+    if (actions[kind]) {
+      return actions[kind]->state;
     }
-    return Action::State::undefined;
+    return previous_action_state[kind];
   }
 
  protected:
@@ -205,15 +206,60 @@ class Robot {
   bool has_camera;
   bool has_tof;
   float last_time_step;
-  std::map<unsigned, Servo *> connected_servos;
+  // 3 EP servos + gimbal yaw and pitch, indexed by port; null if not connected
+  std::array<Servo *, 5> connected_servos;
+  // Bit `i` is set if `connected_servos[i]` is not null
+  uint8_t connected_servo_mask;
 
  private:
   Mode mode;
   bool sdk_enabled;
   float time_;
   std::vector<Callback> callbacks;
-  std::map<std::string, std::unique_ptr<Action>> actions;
-  std::map<std::string, Action::State> previous_action_state;
+  // Actions are submitted by the SDK commands in the IO thread and run in the simulation
+  // thread: `action_mutex` protects them, including their queues and policies.
+  std::mutex action_mutex;
+  std::array<std::unique_ptr<Action>, Action::number_of_kinds> actions;
+  std::array<Action::State, Action::number_of_kinds> previous_action_state;
+  // Bit `kind` is set if `actions[kind]` is running
+  uint8_t active_actions;
+  std::array<std::deque<std::unique_ptr<Action>>, Action::number_of_kinds> queued_actions;
+  std::array<Action::Policy, Action::number_of_kinds> action_policies;
+  std::array<size_t, Action::number_of_kinds> max_queue_lengths;
+
+  // Returns `started`, `queued` or `rejected`, depending on the policy of the kind
+  template <typename T> Action::State start_action(std::unique_ptr<T> action) {
+    constexpr Action::Kind kind = T::kind;
+    std::lock_guard<std::mutex> lock(action_mutex);
+    if (active_actions & (1 << kind)) {
+      switch (action_policies[kind]) {
+      case Action::Policy::reject:
+        return Action::State::rejected;
+      case Action::Policy::queue:
+        if (queued_actions[kind].size() >= max_queue_lengths[kind]) {
+          spdlog::warn("[Robot] Queue of actions of kind {} is full", kind);
+          return Action::State::rejected;
+        }
+        action->state = Action::State::queued;
+        queued_actions[kind].push_back(std::move(action));
+        spdlog::info("[Robot] Queued action of kind {} ({} waiting)", kind,
+                     queued_actions[kind].size());
+        return Action::State::queued;
+      case Action::Policy::preempt:
+        spdlog::info("[Robot] Preempt actions of kind {}", kind);
+        abort_actions(kind);
+        break;
+      }
+    }
+    action->state = Action::State::started;
+    actions[kind] = std::move(action);
+    active_actions |= 1 << kind;
+    return Action::State::started;
+  }
+  // Fail the running and queued actions of this kind. `action_mutex` must be locked.
+  void abort_actions(Action::Kind kind);
+  // Start the next queued action, if any, else free the slot. `action_mutex` must be locked.
+  void start_next_action(Action::Kind kind);
 };
 
 #endif  // INCLUDE_ROBOT_ROBOT_HPP_
@@ -0,0 +1,35 @@
+#ifndef INCLUDE_ROBOT_UART_HPP_
+#define INCLUDE_ROBOT_UART_HPP_
+
+#include <algorithm>
+#include <cstdint>
+
+#include "../event_ring.hpp"
+
+struct UARTData {
+  static constexpr uint16_t max_length = 256;
+  uint16_t length;
+  uint8_t data[max_length];
+};
+
+struct UART {
+  // Data received from the serial port, to be forwarded to the client
+  EventRing<UARTData, 16> received;
+
+  // Split in chunks of at most `UARTData::max_length` bytes.
+  // Returns false if some chunks did not fit in the ring.
+  bool receive(const uint8_t *data, size_t length) {
+    bool ok = true;
+    UARTData chunk;
+    while (length) {
+      chunk.length = std::min<size_t>(length, UARTData::max_length);
+      std::copy(data, data + chunk.length, chunk.data);
+      ok = received.push(chunk) && ok;
+      data += chunk.length;
+      length -= chunk.length;
+    }
+    return ok;
+  }
+};
+
+#endif  //  INCLUDE_ROBOT_UART_HPP_ */
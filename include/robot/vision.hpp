@@ -36,7 +36,8 @@ struct DetectedObjects {
         : x(x)
         , y(y)
         , curvature(curvature)
-        , angle(angle) {}
+        , angle(angle)
+        , info(0) {}
   };
 
   struct Marker {
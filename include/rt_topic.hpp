@@ -0,0 +1,44 @@
+#ifndef INCLUDE_RT_TOPIC_HPP_
+#define INCLUDE_RT_TOPIC_HPP_
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include "topic.hpp"
+
+// A topic published by the IO thread on a wall-clock timer at `sub_freq`, independently of the
+// simulation step: pushes are evenly spaced and continue while the simulation is paused,
+// repeating the last snapshot of the robot state taken at the end of a step.
+struct RealTimeTopic : Topic {
+  RealTimeTopic(boost::asio::io_context *io_context, Commands *_server, Robot *_robot,
+                const AddSubMsg::Request &_request, const std::vector<Subject *> &_subjects);
+  ~RealTimeTopic() { stop(); }
+  void start() override;
+  void stop() override;
+  void sample() override;
+  void set_frequency(float value) override;
+  TopicReport report() override;
+  double now() const override;
+
+ private:
+  // Shared with the pending timer handler, which may run after the topic is destroyed
+  struct State {
+    std::mutex mutex;
+    bool active = false;
+    // Whether `snapshot` has not been pushed yet
+    bool fresh = false;
+    std::vector<uint8_t> snapshot;
+    std::chrono::steady_clock::time_point last_push;
+  };
+  std::shared_ptr<State> state;
+  boost::asio::steady_timer wall_timer;
+  std::chrono::steady_clock::duration period;
+  void schedule();
+};
+
+#endif  // INCLUDE_RT_TOPIC_HPP_
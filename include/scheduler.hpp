@@ -0,0 +1,86 @@
+#ifndef INCLUDE_SCHEDULER_HPP_
+#define INCLUDE_SCHEDULER_HPP_
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// A hierarchical timer wheel that calls periodic callbacks in simulation time.
+//
+// Time is counted in integer ticks and the n-th deadline of a timer is computed from its origin
+// (not by accumulating periods), so rates are exact in the long run. Advancing the wheel only
+// touches the slots that hold due timers: steps where nothing is due cost (almost) nothing,
+// whatever the number of timers.
+class Scheduler {
+ public:
+  using Callback = std::function<void()>;
+
+  // 1 tick = 1 ms of simulation time
+  static constexpr unsigned ticks_per_second = 1000;
+
+  struct Timer {
+    Timer(Callback callback, uint64_t origin, double period)
+        : callback(callback)
+        , active(true)
+        , origin(origin)
+        , period(period)
+        , count(0)
+        , deadline(origin) {}
+
+    // Safe to call at any time, also from the callback or after the scheduler is gone.
+    void cancel() { active = false; }
+
+    Callback callback;
+    bool active;
+    uint64_t origin;
+    // [ticks]
+    double period;
+    uint64_t count;
+    uint64_t deadline;
+  };
+
+  using TimerPtr = std::shared_ptr<Timer>;
+
+  Scheduler();
+
+  /**
+   * Call a function periodically
+   * @param period   The period [s]
+   * @param callback The function to call
+   * @param delay    The delay before the first call [s]
+   * @return         An handle to cancel the timer
+   */
+  TimerPtr schedule(float period, Callback callback, float delay = 0.0f);
+
+  // Advance time, calling the timers that are due (in order)
+  void do_step(float time_step);
+
+  // [s]
+  double get_time() const { return time; }
+
+ private:
+  static constexpr unsigned level_bits = 6;
+  static constexpr unsigned number_of_levels = 5;
+  static constexpr uint64_t number_of_slots = 1 << level_bits;
+  static constexpr uint64_t slot_mask = number_of_slots - 1;
+
+  using Slot = std::vector<TimerPtr>;
+
+  std::array<std::array<Slot, number_of_slots>, number_of_levels> wheel;
+  // A bitmask of non-empty slots per level
+  std::array<uint64_t, number_of_levels> occupied;
+  // Timers due at or before `now`
+  Slot expired;
+  // The last tick processed
+  uint64_t now;
+  double time;
+
+  void insert(const TimerPtr &timer);
+  void cascade(unsigned level);
+  void fire(Slot *slot);
+  void fire_expired();
+};
+
+#endif  // INCLUDE_SCHEDULER_HPP_
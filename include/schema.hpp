@@ -0,0 +1,118 @@
+#ifndef INCLUDE_SCHEMA_HPP_
+#define INCLUDE_SCHEMA_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+#include "spdlog/fmt/fmt.h"
+
+// Compile-time descriptions of wire formats: a schema is a tuple of fields, encoded in order
+// without gaps (little endian, like `write`). From it, we get the payload size as a constant,
+// an encoder without offsets to compute at runtime and a formatter for logging.
+//
+// static constexpr auto fields() {
+//   return std::make_tuple(schema::field<float>(&S::x, "x"), schema::padding<1>(),
+//                          schema::field<int16_t>(&S::array_of_4, "values"));
+// }
+
+namespace schema {
+
+template <typename Wire, typename T> inline void store(uint8_t *buffer, T value) {
+  const Wire wire_value = static_cast<Wire>(value);
+  memcpy(buffer, &wire_value, sizeof(Wire));
+}
+
+// A member (or an array member) of `S`, encoded as `Wire`
+template <typename Wire, typename S, typename M> struct Field {
+  static constexpr size_t count = std::is_array_v<M> ? std::extent_v<M> : 1;
+  static constexpr size_t size = sizeof(Wire) * count;
+
+  M S::*member;
+  const char *name;
+
+  void encode(const S &value, uint8_t *buffer) const {
+    if constexpr (std::is_array_v<M>) {
+      for (size_t i = 0; i < count; i++) {
+        store<Wire>(buffer + i * sizeof(Wire), (value.*member)[i]);
+      }
+    } else {
+      store<Wire>(buffer, value.*member);
+    }
+  }
+
+  void format(const S &value, std::string &text) const {
+    if (!text.empty())
+      text += ", ";
+    text += name;
+    text += ": ";
+    // `+` to print bytes as numbers
+    if constexpr (std::is_array_v<M>) {
+      text += "[";
+      for (size_t i = 0; i < count; i++) {
+        text += fmt::format(i ? ", {}" : "{}", +static_cast<Wire>((value.*member)[i]));
+      }
+      text += "]";
+    } else {
+      text += fmt::format("{}", +static_cast<Wire>(value.*member));
+    }
+  }
+};
+
+// `N` bytes set to zero
+template <size_t N> struct Padding {
+  static constexpr size_t size = N;
+
+  template <typename S> void encode(const S &, uint8_t *buffer) const { memset(buffer, 0, N); }
+  template <typename S> void format(const S &, std::string &) const {}
+};
+
+// A value that does not depend on the state
+template <typename Wire> struct Constant {
+  static constexpr size_t size = sizeof(Wire);
+
+  Wire value;
+
+  template <typename S> void encode(const S &, uint8_t *buffer) const {
+    store<Wire>(buffer, value);
+  }
+  template <typename S> void format(const S &, std::string &) const {}
+};
+
+template <typename Wire, typename S, typename M>
+constexpr Field<Wire, S, M> field(M S::*member, const char *name) {
+  return {member, name};
+}
+
+template <size_t N> constexpr Padding<N> padding() { return {}; }
+
+template <typename Wire> constexpr Constant<Wire> constant(Wire value) { return {value}; }
+
+template <typename... F> constexpr size_t size(const std::tuple<F...> &) {
+  return (F::size + ... + 0);
+}
+
+// Write the fields of `value` to `buffer`, which must hold at least `size(fields)` bytes
+template <typename S, typename... F>
+void encode(const S &value, const std::tuple<F...> &fields, uint8_t *buffer) {
+  std::apply(
+      [&value, buffer](const F &...field) {
+        size_t offset = 0;
+        ((field.encode(value, buffer + offset), offset += F::size), ...);
+      },
+      fields);
+}
+
+// "name_1: value_1, name_2: [value_2_0, value_2_1], ..."
+template <typename S, typename... F>
+std::string format(const S &value, const std::tuple<F...> &fields) {
+  std::string text;
+  std::apply([&value, &text](const F &...field) { (field.format(value, text), ...); }, fields);
+  return text;
+}
+
+}  // namespace schema
+
+#endif  // INCLUDE_SCHEMA_HPP_
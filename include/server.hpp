@@ -38,6 +38,9 @@ class Server {
 
   udp::endpoint local_endpoint() { return socket_.local_endpoint(); }
 
+  // Process a datagram as if it had been received from `sender` (e.g., to replay traces)
+  void inject(const uint8_t *raw_request, size_t length, const udp::endpoint &sender);
+
  protected:
   boost::asio::io_context *io_context;
   Robot *robot;
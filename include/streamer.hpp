@@ -1,8 +1,16 @@
 #ifndef INCLUDE_STREAMER_HPP_
 #define INCLUDE_STREAMER_HPP_
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <boost/asio.hpp>
 
@@ -13,28 +21,178 @@ namespace ba = boost::asio;
 
 #define DEFAULT_BITRATE 200000
 
+struct BitrateSample {
+  // Since the start of the stream [s]
+  double time;
+  // [bits/s]
+  unsigned bitrate;
+  // The most bytes still queued behind a completed write during the last period [bytes]
+  size_t queued_bytes;
+  // The longest latency of the writes completed during the last period [s]
+  double latency;
+};
+
+struct VideoStats {
+  // Frames submitted by the simulation
+  unsigned frames;
+  // Frames discarded before encoding because the encoder was late
+  unsigned dropped;
+  unsigned encoded;
+  // [bytes]
+  size_t encoded_bytes;
+  // [s]
+  double encode_time;
+  // Frame writes that completed, one per viewer
+  unsigned sent;
+  // [bytes]
+  size_t sent_bytes;
+  // Frame writes discarded because a connection was congested, one per viewer
+  unsigned skipped;
+  // [bytes]
+  size_t skipped_bytes;
+  // Encoded bytes waiting to be written to the slowest viewer [bytes]
+  size_t queued_bytes;
+  size_t queued_bytes_max;
+  // From the submission of a frame to the completion of its write [s]
+  double latency_sum;
+  double latency_max;
+  // The target of the encoder [bits/s]
+  unsigned bitrate;
+  // One sample per adaptation of the bitrate, the last `max_bitrate_history` only
+  std::deque<BitrateSample> bitrate_history;
+
+  VideoStats()
+      : frames(0)
+      , dropped(0)
+      , encoded(0)
+      , encoded_bytes(0)
+      , encode_time(0.0)
+      , sent(0)
+      , sent_bytes(0)
+      , skipped(0)
+      , skipped_bytes(0)
+      , queued_bytes(0)
+      , queued_bytes_max(0)
+      , latency_sum(0.0)
+      , latency_max(0.0)
+      , bitrate(0) {}
+  // [s]
+  double latency() const { return sent ? latency_sum / sent : 0.0; }
+  std::string summary() const;
+  std::string bitrate_summary() const;
+};
+
+using VideoClock = std::chrono::steady_clock;
+
+struct EncodedFrame {
+  PacketPtr packet;
+  uint64_t seq;
+  // When the raw frame was submitted to the streamer
+  VideoClock::time_point submitted;
+};
+
+// Frames are encoded by a worker thread, so that the simulation step does not depend on the
+// video resolution or bitrate. `send` adds a reference to the frame to a short queue: when the
+// encoder falls behind, the oldest queued frame is dropped. Encoded frames are sent from the IO
+// thread.
 class VideoStreamer {
  public:
-  explicit VideoStreamer(Robot *robot, unsigned bitrate = DEFAULT_BITRATE);
+  VideoStreamer(ba::io_context *io_context, Robot *robot, unsigned bitrate = DEFAULT_BITRATE);
   static std::unique_ptr<VideoStreamer> create_video_streamer(ba::io_context *io_context,
                                                               Robot *robot, std::string ip = "",
                                                               bool udp = false,
                                                               unsigned bitrate = DEFAULT_BITRATE);
-  void send(uint8_t *buffer);
+  void send(FramePtr frame);
   void stop();
   void start(const ba::ip::address &address, unsigned image_width, unsigned image_height, int fps);
   void do_step(float);
   virtual ~VideoStreamer();
+  bool is_active() const { return active; }
+  // The current target of the encoder [bits/s]
+  unsigned get_bitrate() const { return target_bitrate; }
+  // Adapts the bitrate to the connections, between `min_bitrate` and `max_bitrate` [bits/s]:
+  // lower when frames wait behind the writes or are skipped, higher when they are written
+  // promptly. TCP only: UDP writes complete without feedback from the client, so the bitrate
+  // stays fixed. Disabled if `max_bitrate` is 0 (default). Applies to the next stream.
+  void set_adaptive_bitrate(unsigned min_bitrate, unsigned max_bitrate);
+  // Apply to the next stream
+  void set_encoder(Encoder::Backend value) { backend = value; }
+  Encoder::Backend get_encoder() const { return backend; }
+  void set_format(Encoder::Format value) { format = value; }
+  void set_profile(Encoder::Profile value) { profile = value; }
+  VideoStats get_stats();
 
  protected:
-  bool active;
+  ba::io_context *io_context;
+  std::atomic<bool> active;
+  // Of the first frames [bits/s]
   unsigned bitrate;
+  // Of the current stream [frames/s]
+  int fps;
+  // To be called by subclasses in the IO thread, when the write of `frame` completes, with
+  // `backlog` bytes still queued behind it
+  void sent(const EncodedFrame &frame, size_t backlog = 0);
+  // ... when they discard `frame` instead of sending it, because the connection is `congested`
+  // or for another reason (e.g., the viewer waits for a keyframe)
+  void skipped(const EncodedFrame &frame, bool congested = false);
+  // ... when the number of bytes waiting to be written changes
+  void queued(size_t bytes);
 
  private:
+  static constexpr size_t max_queued_frames = 2;
+  static constexpr std::chrono::seconds adaptation_period{1};
+  static constexpr size_t max_bitrate_history = 60;
+
   Robot *robot;
+  struct QueuedFrame {
+    FramePtr frame;
+    VideoClock::time_point submitted;
+  };
+
   std::unique_ptr<Encoder> encoder;
+  // Creates an encoder for the current stream with a given bitrate
+  std::function<std::unique_ptr<Encoder>(unsigned)> create_encoder;
+  // Used by the worker thread only
+  unsigned encoder_bitrate;
+  std::atomic<unsigned> target_bitrate;
+  Encoder::Backend backend;
+  Encoder::Format format;
+  Encoder::Profile profile;
   uint64_t seq;
-  virtual void send_buffer(ba::const_buffer &) = 0;
+  unsigned width;
+  unsigned height;
+  std::thread worker;
+  // Serializes `start` and `stop`, which the IO and the simulation threads may call
+  std::mutex control_mutex;
+  std::mutex mutex;
+  std::condition_variable frame_ready;
+  // Protected by `mutex`
+  bool encoding;
+  std::deque<QueuedFrame> frames;
+  VideoStats stats;
+  // Set by `set_adaptive_bitrate`, copied to the stream bounds by `start`
+  unsigned min_bitrate;
+  unsigned max_bitrate;
+  unsigned stream_min_bitrate;
+  unsigned stream_max_bitrate;
+  VideoClock::time_point stream_start;
+  VideoClock::time_point last_adaptation;
+  // Since the last adaptation
+  size_t recent_backlog;
+  double recent_latency;
+  // Because of congestion
+  unsigned recent_skipped;
+  void encode_frames();
+  // To be called with `mutex` locked, from the IO thread
+  void adapt_bitrate(VideoClock::time_point now);
+  void stop_worker();
+  // The sockets and their write queues belong to the IO thread: these are called there only,
+  // also when `start` and `stop` are called from another thread (e.g., the simulation).
+  // `frame` must stay alive until the write completes.
+  virtual void send_buffer(std::shared_ptr<const EncodedFrame> frame) = 0;
+  // Whether `sent` gets the backlog of the writes and their completion tells that the client
+  // received the frame
+  virtual bool can_adapt_bitrate() const { return false; }
   virtual void start_socket(const ba::ip::address &address) = 0;
   virtual void stop_socket() = 0;
 };
@@ -1,18 +1,114 @@
 #ifndef INCLUDE_SUBJECT_HPP_
 #define INCLUDE_SUBJECT_HPP_
 
+#include <cmath>
 #include <cstdint>
 #include <string>
 #include <vector>
 
+#include "schema.hpp"
+
 class Robot;
 
+// When topics push a subject
+struct PublishPolicy {
+  enum class Mode {
+    // at every period
+    always,
+    // when the encoded data changes
+    on_change,
+    // when at least one of the values changes more than `deadband`
+    deadband
+  };
+
+  Mode mode;
+  // In the units of the subject values (see `Subject::values`)
+  float deadband;
+  // Push at least every `keepalive` seconds, also if nothing changed
+  float keepalive;
+
+  explicit PublishPolicy(Mode mode = Mode::always, float deadband = 0.0f, float keepalive = 1.0f)
+      : mode(mode)
+      , deadband(deadband)
+      , keepalive(keepalive) {}
+};
+
+// Parses "always", "on_change" or "deadband"
+inline bool publish_mode_from_string(const std::string &value, PublishPolicy::Mode *mode) {
+  if (value == "always") {
+    *mode = PublishPolicy::Mode::always;
+  } else if (value == "on_change") {
+    *mode = PublishPolicy::Mode::on_change;
+  } else if (value == "deadband") {
+    *mode = PublishPolicy::Mode::deadband;
+  } else {
+    return false;
+  }
+  return true;
+}
+
 struct Subject {
   virtual std::vector<uint8_t> encode() = 0;
   virtual void update(Robot *) = 0;
-  Subject() {}
+  Subject()
+      : policy()
+      , priority(1.0f)
+      , fresh(false) {}
   virtual ~Subject() {}
   virtual std::string name() = 0;
+
+  // Encode into a buffer reused between steps. Override to avoid allocations.
+  virtual void encode_into(std::vector<uint8_t> &buffer) { buffer = encode(); }
+
+  // A readable description of the current state, for logging
+  virtual std::string format() { return ""; }
+
+  // The fields compared to the deadband. Subjects without values compare the encoded data.
+  virtual std::vector<float> values() { return {}; }
+
+  PublishPolicy policy;
+  // When the bandwidth is limited, topics with higher priority are slowed down less
+  float priority;
+
+  // Update and encode the subject at most once per step, i.e., until `invalidate` is called.
+  const std::vector<uint8_t> &data(Robot *robot) {
+    if (!fresh) {
+      update(robot);
+      encode_into(cached_data);
+      fresh = true;
+    }
+    return cached_data;
+  }
+
+  void invalidate() { fresh = false; }
+
+  // Whether, according to `policy`, a client that received `last_data` and `last_values`
+  // should get the current state
+  bool changed(Robot *robot, const std::vector<uint8_t> &last_data,
+               const std::vector<float> &last_values) {
+    const auto &current_data = data(robot);
+    switch (policy.mode) {
+    case PublishPolicy::Mode::always:
+      return true;
+    case PublishPolicy::Mode::on_change:
+      return current_data != last_data;
+    case PublishPolicy::Mode::deadband: {
+      const auto current_values = values();
+      if (current_values.empty() || current_values.size() != last_values.size())
+        return current_data != last_data;
+      for (size_t i = 0; i < current_values.size(); i++) {
+        if (std::abs(current_values[i] - last_values[i]) > policy.deadband)
+          return true;
+      }
+      return false;
+    }
+    }
+    return true;
+  }
+
+ private:
+  bool fresh;
+  std::vector<uint8_t> cached_data;
 };
 
 template <uint64_t _uid> struct SubjectWithUID : Subject {
@@ -20,4 +116,24 @@ template <uint64_t _uid> struct SubjectWithUID : Subject {
   SubjectWithUID() {}
 };
 
+// A subject whose wire format is generated from `S::fields()` (see schema.hpp)
+template <uint64_t _uid, typename S> struct SubjectWithSchema : SubjectWithUID<_uid> {
+  static constexpr size_t size() { return schema::size(S::fields()); }
+
+  std::vector<uint8_t> encode() override {
+    std::vector<uint8_t> buffer;
+    encode_into(buffer);
+    return buffer;
+  }
+
+  void encode_into(std::vector<uint8_t> &buffer) override {
+    buffer.resize(size());
+    schema::encode(static_cast<const S &>(*this), S::fields(), buffer.data());
+  }
+
+  std::string format() override {
+    return schema::format(static_cast<const S &>(*this), S::fields());
+  }
+};
+
 #endif  // INCLUDE_SUBJECT_HPP_
@@ -1,12 +1,13 @@
 #ifndef INCLUDE_TOPIC_HPP_
 #define INCLUDE_TOPIC_HPP_
 
-#include <memory>
-#include <utility>
+#include <string>
 #include <vector>
 
+#include "scheduler.hpp"
 #include "subject.hpp"
 #include "subscriber_messages.hpp"
+#include "topic_stats.hpp"
 
 class Commands;
 
@@ -14,23 +15,62 @@ struct Topic {
   Commands *server;
   Robot *robot;
   AddSubMsg::Request request;
-  std::unique_ptr<Subject> subject;
-  float deadline;
-  bool active;
+  // In the order of `request.sub_uid_list`, shared with other topics (see `Commands::subjects`).
+  // Their data is concatenated in a single push, like the real firmware does.
+  std::vector<Subject *> subjects;
+  Scheduler::TimerPtr timer;
+  // The effective frequency, lower than `request.sub_freq` when the bandwidth is limited [Hz]
+  float frequency;
+  // The size of the last push, including the UDP and IP headers [bytes]
+  size_t message_size;
+  TopicStats stats;
 
   Topic(Commands *_server, Robot *_robot, const AddSubMsg::Request &_request,
-        std::unique_ptr<Subject> _subject)
+        const std::vector<Subject *> &_subjects)
       : server(_server)
       , robot(_robot)
       , request(_request)
-      , subject(std::move(_subject)) {}
+      , subjects(_subjects)
+      , frequency(_request.sub_freq)
+      , message_size(0)
+      , stats()
+      , last_push_time(0.0)
+      , last_publish_time(-1.0) {}
 
   virtual ~Topic() { stop(); }
-  void do_step(float time_step);
   virtual void start();
   virtual void stop();
+  // Called at the end of each simulation step by topics that are not published
+  // by the scheduler (see `RealTimeTopic`)
+  virtual void sample() {}
+  virtual void set_frequency(float value);
+  // The highest priority of the subjects
+  float priority() const;
+  // Pushes happen at times t such that t * frequency = phase (mod 1), so that topics with the
+  // same (or harmonic) frequencies do not all push at the same step.
+  float phase() const;
+  // The delay to the next push, when starting at `time` [s]
+  float delay(double time) const;
   void publish();
-  std::vector<uint8_t> subject_data();
+  void push(const std::vector<uint8_t> &payload);
+  const std::vector<uint8_t> &subject_data();
+  std::string name() const;
+  // Applies the publish policies of the subjects to the current state, at `time` [s]
+  bool should_push(double time);
+  // The longest time without pushes allowed by the policies [s], 0 to push at every period
+  float keepalive() const;
+  virtual TopicReport report();
+  // The clock of the pushes [s]: simulation time, or wall time for real-time topics
+  virtual double now() const;
+
+ private:
+  std::vector<uint8_t> buffer;
+  // What the client last received, one item per subject
+  std::vector<std::vector<uint8_t>> last_data;
+  std::vector<std::vector<float>> last_values;
+  double last_push_time;
+  // Simulation time of the last call of `publish` [s]
+  double last_publish_time;
 };
 
 #endif  // INCLUDE_TOPIC_HPP_
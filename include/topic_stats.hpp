@@ -0,0 +1,66 @@
+#ifndef INCLUDE_TOPIC_STATS_HPP_
+#define INCLUDE_TOPIC_STATS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Delivery statistics of a topic.
+//
+// Jitter is the difference between the interval between consecutive pushes and the expected
+// period, measured by the clock that drives the topic (simulation time or, for real-time
+// topics, wall time). Its percentile uses the most recent pushes only.
+class TopicStats {
+ public:
+  TopicStats();
+
+  // A push of `size` bytes at `time` [s], expected `period` [s] after the previous one
+  void add_push(double time, size_t size, float period);
+
+  // The number of pushes
+  unsigned pushes;
+  // [bytes], including the UDP and IP headers
+  size_t bytes;
+  // Not pushed because the state did not change (see `PublishPolicy`)
+  unsigned skipped;
+  // Not pushed because the publisher was late (real-time topics)
+  unsigned dropped;
+  // Pushed more than once in the same simulation step, i.e., with the same data
+  unsigned duplicated;
+
+  // The achieved rate [Hz]
+  float rate() const;
+  // [s]
+  float jitter_min() const;
+  float jitter_avg() const;
+  float jitter_max() const;
+  float jitter_p99() const;
+
+  std::string summary() const;
+
+ private:
+  static constexpr size_t window = 1024;
+  double first_push;
+  double last_push;
+  unsigned intervals;
+  double jitter_sum;
+  float min_jitter;
+  float max_jitter;
+  std::vector<float> recent_jitter;
+  size_t next;
+};
+
+// The statistics of a topic, with what identifies it
+struct TopicReport {
+  std::string name;
+  uint8_t node_id;
+  uint8_t msg_id;
+  // [Hz]
+  float requested_frequency;
+  // [Hz], see `Topic::frequency`
+  float frequency;
+  TopicStats stats;
+};
+
+#endif  // INCLUDE_TOPIC_STATS_HPP_
@@ -373,6 +373,26 @@ template <typename T> void write(std::vector<uint8_t> &buffer, size_t index, T v
   }
 }
 
+// The indices of the bits set in `mask`, from the lowest: for (unsigned i : Bits(mask)) {...}
+struct Bits {
+  struct Iterator {
+    uint32_t mask;
+    unsigned operator*() const { return __builtin_ctz(mask); }
+    Iterator &operator++() {
+      mask &= mask - 1;
+      return *this;
+    }
+    bool operator!=(const Iterator &other) const { return mask != other.mask; }
+  };
+
+  explicit Bits(uint32_t mask)
+      : mask(mask) {}
+  Iterator begin() const { return {mask}; }
+  Iterator end() const { return {0}; }
+
+  uint32_t mask;
+};
+
 template <class T> using ServoValues = std::array<T, 3>;
 
 template <typename OStream, typename T> OStream &operator<<(OStream &os, const ServoValues<T> &v) {
@@ -0,0 +1,20 @@
+#ifndef INCLUDE_YUV_HPP_
+#define INCLUDE_YUV_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+// Conversion of packed RGB24 images to planar YUV 4:2:0 (BT.601, limited range), i.e., what
+// `libx264` expects. Chroma is the average of each 2x2 block. Width and height must be even.
+//
+// Uses SSSE3 when the CPU supports it, else `rgb_to_yuv420p_scalar`, which gives the same result.
+void rgb_to_yuv420p(const uint8_t *rgb, unsigned width, unsigned height, uint8_t *y,
+                    int y_stride, uint8_t *u, int u_stride, uint8_t *v, int v_stride);
+
+void rgb_to_yuv420p_scalar(const uint8_t *rgb, unsigned width, unsigned height, uint8_t *y,
+                           int y_stride, uint8_t *u, int u_stride, uint8_t *v, int v_stride);
+
+// Whether `rgb_to_yuv420p` uses SIMD instructions on this CPU
+bool rgb_to_yuv420p_is_vectorized();
+
+#endif  // INCLUDE_YUV_HPP_
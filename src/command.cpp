@@ -12,6 +12,7 @@
 #include "command_subjects.hpp"
 #include "event.hpp"
 #include "robomaster.hpp"
+#include "rt_topic.hpp"
 #include "subscriber_messages.hpp"
 
 #define MAX_HEARTBEAT_DELAY 3.0
@@ -19,10 +20,7 @@
 using boost::asio::ip::udp;
 
 bool AddSubMsg::answer(const Request &request, Response &response, Robot *robot, Commands *server) {
-  for (size_t i = 0; i < request.sub_data_num; i++) {
-    uint64_t uid = request.sub_uid_list[i];
-    server->create_publisher(uid, request);
-  }
+  server->create_publisher(request);
   return true;
 }
 
@@ -37,6 +35,11 @@ Commands::Commands(boost::asio::io_context *_io_context, Robot *robot, RoboMaste
     , robomaster(rm)
     , enable_armor_hits(enable_armor_hits)
     , enable_ir_hits(enable_ir_hits)
+    , real_time_topics(false)
+    , vision_on_change(false)
+    , bandwidth_budget(0.0f)
+    , rates_timer(nullptr)
+    , rates_need_update(false)
     , _time(0.0)
     , connected(false) {
   register_message<SdkHeartBeat, Commands *>(this);
@@ -103,11 +106,13 @@ Commands::Commands(boost::asio::io_context *_io_context, Robot *robot, RoboMaste
   register_subject<TofSubject>();
   register_subject<GimbalPosSubject>();
   register_subject<AdapterSubject>();
+  rates_timer = get_scheduler()->schedule(
+      1.0f, [this]() { rates_need_update = true; }, 1.0f);
   spdlog::info("[Commands] Start listening on {}", local_endpoint());
   start();
 }
 
-Commands::~Commands() {}
+Commands::~Commands() { rates_timer->cancel(); }
 
 void Commands::add_subscriber_node(uint8_t node_id) {
   spdlog::info("[Commands] add subscriber {}", node_id);
@@ -115,8 +120,8 @@ void Commands::add_subscriber_node(uint8_t node_id) {
     armor_hit_event = std::make_unique<ArmorHitEvent>(this, robot, node_id);
   if (enable_ir_hits)
     ir_hit_event = std::make_unique<IRHitEvent>(this, robot, node_id);
-  // Disabled
-  // uart_event = std::make_unique<UARTEvent>(this, robot);
+  // Pushes only what the backend receives from the serial port
+  uart_event = std::make_unique<UARTEvent>(this, robot);
   last_heartbeat = _time;
   connected = true;
 }
@@ -138,23 +143,142 @@ void Commands::set_enable_sdk(bool value) {
     spdlog::info("[Commands] disabled the SDK");
     armor_hit_event = nullptr;
     ir_hit_event = nullptr;
-    vision_event = nullptr;
-    armor_hit_event = nullptr;
+    uart_event = nullptr;
     vision_event = nullptr;
     publishers.clear();
   }
 }
 
-void Commands::create_publisher(uint64_t uid, const AddSubMsg::Request &request) {
+void Commands::create_publisher(const AddSubMsg::Request &request) {
   uint16_t key = key_from(request.node_id, request.msg_id);
-  if (!subjects.count(uid)) {
-    spdlog::warn("Unknown subject uid {}", uid);
+  std::vector<Subject *> topic_subjects;
+  for (size_t i = 0; i < request.sub_data_num; i++) {
+    uint64_t uid = request.sub_uid_list[i];
+    if (!subjects.count(uid)) {
+      // The client would not be able to decode the data of the other subjects
+      spdlog::warn("Unknown subject uid {}: will not publish msg {}", uid, request.msg_id);
+      return;
+    }
+    topic_subjects.push_back(subjects[uid].get());
+  }
+  if (topic_subjects.empty())
     return;
+  if (real_time_topics) {
+    publishers[key] =
+        std::make_unique<RealTimeTopic>(io_context, this, robot, request, topic_subjects);
+  } else {
+    publishers[key] = std::make_unique<Topic>(this, robot, request, topic_subjects);
   }
-  // auto subject = subjects[uid]();
-  // publishers[key] = topic;
-  publishers.emplace(key, std::make_unique<Topic>(this, robot, request, subjects[uid]()));
   publishers[key]->start();
+  rates_need_update = true;
+}
+
+bool Commands::set_publish_policy(const std::string &name, const PublishPolicy &policy) {
+  bool found = false;
+  for (auto const &[uid, subject] : subjects) {
+    if (name.empty() || subject->name() == name) {
+      subject->policy = policy;
+      found = true;
+    }
+  }
+  if (!found)
+    spdlog::warn("[Commands] Unknown subject {}", name);
+  return found;
+}
+
+bool Commands::set_priority(const std::string &name, float priority) {
+  bool found = false;
+  for (auto const &[uid, subject] : subjects) {
+    if (name.empty() || subject->name() == name) {
+      subject->priority = priority;
+      found = true;
+    }
+  }
+  if (!found)
+    spdlog::warn("[Commands] Unknown subject {}", name);
+  rates_need_update = true;
+  return found;
+}
+
+void Commands::set_bandwidth_budget(float bytes_per_second) {
+  spdlog::info("[Commands] Set bandwidth budget to {} bytes/s", bytes_per_second);
+  bandwidth_budget = std::max(0.0f, bytes_per_second);
+  rates_need_update = true;
+}
+
+void Commands::update_topic_rates() {
+  // Topics below this frequency are not slowed down further [Hz]
+  static constexpr float min_frequency = 1.0f;
+  float budget = bandwidth_budget;
+  auto video = get_video_streamer();
+  if (budget > 0 && video && video->is_active()) {
+    budget -= video->get_bitrate() / 8.0f;
+  }
+  // Water filling: topic i gets a fraction min(1, k * priority_i) of its requested rate,
+  // with k such that the total fits the budget.
+  std::map<Topic *, float> scale;
+  std::map<Topic *, float> demand;
+  float remaining = budget;
+  for (auto const &[key, pub] : publishers) {
+    demand[pub.get()] = pub->request.sub_freq * pub->message_size;
+    scale[pub.get()] = 1.0f;
+  }
+  if (bandwidth_budget > 0) {
+    std::vector<Topic *> limited;
+    for (auto const &[topic, _] : demand) {
+      limited.push_back(topic);
+    }
+    bool changed = true;
+    while (changed && !limited.empty()) {
+      changed = false;
+      float weighted_demand = 0.0f;
+      for (auto topic : limited) {
+        weighted_demand += topic->priority() * demand[topic];
+      }
+      if (weighted_demand <= 0)
+        break;
+      const float k = std::max(0.0f, remaining) / weighted_demand;
+      for (auto it = limited.begin(); it != limited.end();) {
+        scale[*it] = k * (*it)->priority();
+        if (scale[*it] >= 1.0f) {
+          scale[*it] = 1.0f;
+          remaining -= demand[*it];
+          it = limited.erase(it);
+          changed = true;
+        } else {
+          ++it;
+        }
+      }
+    }
+  }
+  for (auto const &[topic, value] : scale) {
+    const float requested = topic->request.sub_freq;
+    const float frequency = std::clamp(value * requested, std::min(min_frequency, requested),
+                                       requested);
+    // Avoid rescheduling for small changes
+    if (frequency != topic->frequency &&
+        (frequency == requested || std::abs(frequency - topic->frequency) > 0.05f * frequency)) {
+      spdlog::info("[Topic] {} @ {:.1f} Hz (requested {} Hz)", topic->name(), frequency,
+                   requested);
+      topic->set_frequency(frequency);
+    }
+  }
+}
+
+std::vector<TopicReport> Commands::get_topic_stats() {
+  std::vector<TopicReport> reports;
+  for (auto const &[key, pub] : publishers) {
+    reports.push_back(pub->report());
+  }
+  return reports;
+}
+
+void Commands::dump_topic_stats() {
+  for (const auto &report : get_topic_stats()) {
+    spdlog::info("[Topic] {} (node {}, msg {}) @ {:.1f}/{} Hz: {}", report.name, report.node_id,
+                 report.msg_id, report.frequency, report.requested_frequency,
+                 report.stats.summary());
+  }
 }
 
 void Commands::stop_publisher(const DelMsg::Request &request) {
@@ -164,9 +288,14 @@ void Commands::stop_publisher(const DelMsg::Request &request) {
 
 void Commands::do_step(float time_step) {
   // spdlog::debug("[Commands] do_step");
+  // Topics are published by the scheduler, before this is called,
+  // real-time topics by the IO thread, using the state sampled here.
   for (auto const &[key, pub] : publishers) {
-    // spdlog::debug("[Pub] do_step");
-    pub->do_step(time_step);
+    pub->sample();
+  }
+  if (rates_need_update) {
+    rates_need_update = false;
+    update_topic_rates();
   }
   if (vision_event)
     vision_event->do_step(time_step);
@@ -176,6 +305,10 @@ void Commands::do_step(float time_step) {
     ir_hit_event->do_step(time_step);
   if (uart_event)
     uart_event->do_step(time_step);
+  // The robot state will change before the next step
+  for (auto const &[uid, subject] : subjects) {
+    subject->invalidate();
+  }
   // check the hearbeat
   _time += time_step;
   if (connected && (_time - last_heartbeat > MAX_HEARTBEAT_DELAY)) {
@@ -187,8 +320,16 @@ void Commands::do_step(float time_step) {
 
 VideoStreamer *Commands::get_video_streamer() { return robomaster->get_video_streamer(); }
 
+Scheduler *Commands::get_scheduler() { return robomaster->get_scheduler(); }
+
 void Commands::set_vision_request(uint8_t sender, uint8_t request, uint16_t mask) {
-  vision_event = std::make_unique<VisionEvent>(this, robot, sender, request, mask);
+  vision_event = std::make_unique<VisionEvent>(this, robot, sender, request, mask, vision_on_change);
+}
+
+void Commands::set_vision_on_change(bool value) {
+  vision_on_change = value;
+  if (vision_event)
+    vision_event->only_on_change = value;
 }
 
 void Commands::unconnect() {
@@ -197,6 +338,7 @@ void Commands::unconnect() {
   get_video_streamer()->stop();
   armor_hit_event = nullptr;
   ir_hit_event = nullptr;
+  uart_event = nullptr;
   vision_event = nullptr;
   publishers.clear();
   connected = false;
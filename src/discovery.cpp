@@ -5,12 +5,14 @@
 
 #define PORT 39393
 
-Discovery::Discovery(boost::asio::io_context *io_context, std::string serial_number, std::string ip,
-                     unsigned prefix_len, float period_, const std::string app_id)
+Discovery::Discovery(boost::asio::io_context *io_context, Scheduler *scheduler_,
+                     std::string serial_number, std::string ip, unsigned prefix_len,
+                     float period_, const std::string app_id)
     : socket(*io_context, ip.size() ? udp::endpoint(ba::ip::address::from_string(ip), PORT)
                                     : udp::endpoint(udp::v4(), PORT))
+    , scheduler(scheduler_)
     , period(period_)
-    , active(false) {
+    , timer(nullptr) {
   socket.set_option(boost::asio::socket_base::broadcast(true));
   message = serial_number;
   // CHANGED(Jerome): comply with robomaster sending different messages on each port
@@ -37,20 +39,14 @@ Discovery::Discovery(boost::asio::io_context *io_context, std::string serial_num
 
 void Discovery::start() {
   spdlog::info("[Discovery] Start broadcasting to {}", broadcast_address.to_string());
-  active = true;
-  deadline = period;
+  stop();
+  timer = scheduler->schedule(period, std::bind(&Discovery::publish, this), period);
 }
 
-void Discovery::stop() { active = false; }
-
-void Discovery::do_step(float time_step) {
-  if (!active)
-    return;
-  deadline -= time_step;
-  if (deadline < 0) {
-    publish();
-    deadline += period;
-  }
+void Discovery::stop() {
+  if (timer)
+    timer->cancel();
+  timer = nullptr;
 }
 
 void Discovery::publish() {
@@ -1,25 +1,28 @@
+#include <cmath>
+#include <cstring>
+
 #include "spdlog/spdlog.h"
 
 #include "dummy_robot.hpp"
 
-static std::vector<uint8_t> generate_strip_image(unsigned i0, unsigned i1, unsigned width,
-                                                 unsigned height) {
+static void generate_strip_image(unsigned i0, unsigned i1, unsigned width, unsigned height,
+                                 uint8_t *buffer) {
   unsigned size = width * height * 3;
-  std::vector<uint8_t> buffer(size, 0);
+  memset(buffer, 0, size);
   if (i0 > i1)
     i1 += width;
   for (size_t i = i0; i < i1; i++)
     for (size_t j = 0; j < height; j++)
       buffer[(3 * (j * width + i)) % size] = 255;
-  return buffer;
 }
 
 void DummyRobot::do_step(float time_step) {
   chassis.wheel_speeds.current = chassis.wheel_speeds.target;
   chassis.wheel_angles = chassis.wheel_angles + chassis.wheel_speeds.current * last_time_step;
 
-  std::map<unsigned, float> angles;
-  for (auto const &[i, servo] : connected_servos) {
+  std::array<float, 5> angles;
+  for (unsigned i : Bits(connected_servo_mask)) {
+    Servo *servo = connected_servos[i];
     angles[i] = servo->angle.current;
     servo->angle.current = std::clamp(servo->angle.current + servo->speed.target * time_step,
                                       servo->min_angle, servo->max_angle);
@@ -27,7 +30,8 @@ void DummyRobot::do_step(float time_step) {
   if (has_arm) {
     arm.limit_motor_angles(CURRENT);
   }
-  for (auto const &[i, servo] : connected_servos) {
+  for (unsigned i : Bits(connected_servo_mask)) {
+    Servo *servo = connected_servos[i];
     servo->speed.current = (servo->angle.current - angles[i]) / time_step;
   }
   if (has_gripper) {
@@ -46,6 +50,12 @@ void DummyRobot::do_step(float time_step) {
   //     servo->speed.current = (servo->angle.current - angle) / last_time_step;
   //   }
   // }
+  // One armor hit (cycling through the armors) and one IR hit per second
+  const unsigned second = std::floor(get_time() + time_step);
+  if (second > std::floor(get_time())) {
+    armor.hit_events.push({.type = 0, .index = static_cast<uint8_t>(second % 6)});
+    armor.ir_events.push({});
+  }
   Robot::do_step(time_step);
 }
 
@@ -53,10 +63,11 @@ WheelSpeeds DummyRobot::read_wheel_speeds() const { return chassis.wheel_speeds.
 void DummyRobot::forward_target_wheel_speeds(const WheelSpeeds &) {}
 WheelValues<float> DummyRobot::read_wheel_angles() const { return chassis.wheel_angles; }
 
-std::vector<uint8_t> DummyRobot::read_camera_image() const {
+bool DummyRobot::read_camera_image(CameraFrame *frame) const {
   static unsigned seq = 0;
-  seq = (seq + 1) % camera.width;
-  return generate_strip_image(seq, seq + 10, camera.width, camera.height);
+  seq = (seq + 1) % frame->width;
+  generate_strip_image(seq, seq + 10, frame->width, frame->height, frame->data());
+  return true;
 }
 
 void DummyRobot::forward_chassis_led(size_t index, const Color &color) {}
@@ -129,9 +140,6 @@ DetectedObjects DummyRobot::read_detected_objects() const {
   return objects;
 }
 
-hit_event_t DummyRobot::read_hit_events() const { return {{.type = 0, .index = 0}}; }
-
-ir_event_t DummyRobot::read_ir_events() const { return {{}}; }
 
 float DummyRobot::read_tof(size_t index) const {
   return 0.89;
@@ -1,21 +1,40 @@
 #include "spdlog/spdlog.h"
 
 #include "encoder.hpp"
+#include "yuv.hpp"
 
 extern "C" {
 #include "libavutil/opt.h"
 }
 
-Encoder::Encoder(unsigned bitrate, unsigned width, unsigned height, int fps) :
+std::unique_ptr<Encoder> Encoder::create(Backend backend, unsigned bitrate, unsigned width,
+                                         unsigned height, int fps, Format format,
+                                         Profile profile) {
+  switch (backend) {
+  case mjpeg:
+    return std::make_unique<MJPEGEncoder>(bitrate, width, height, fps);
+  case raw:
+    return std::make_unique<RawEncoder>(width, height);
+  case x264:
+  default:
+    return std::make_unique<H264Encoder>(bitrate, width, height, fps, format, profile);
+  }
+}
+
+AVPacketRef::AVPacketRef(AVPacket *_packet)
+    : packet(av_packet_alloc()) {
+  av_packet_move_ref(packet, _packet);
+}
+
+AVPacketRef::~AVPacketRef() { av_packet_free(&packet); }
+
+LibAVEncoder::LibAVEncoder(const char *codec_name, unsigned bitrate, unsigned width,
+                           unsigned height, int fps, AVPixelFormat pix_fmt) :
   codec(nullptr), c(nullptr), frame(nullptr), pkt(nullptr), seq(0), ready(false) {
-  spdlog::info("Initializing an H264 encoder with input ({}, {}), fps {} and bitrate {}", width,
-               height, fps, bitrate);
   // avcodec_register_all();
-  /* find the h264 encoder */
-  // codec = avcodec_find_encoder(AV_CODEC_ID_H264);
-  codec = avcodec_find_encoder_by_name("libx264rgb");
+  codec = avcodec_find_encoder_by_name(codec_name);
   if (!codec) {
-    spdlog::error("H264 codec not found");
+    spdlog::error("Codec {} not found", codec_name);
     return;
   }
   c = avcodec_alloc_context3(codec);
@@ -33,38 +52,15 @@ Encoder::Encoder(unsigned bitrate, unsigned width, unsigned height, int fps) :
   c->width = width;
   c->height = height;
 
-  // format_ctx->max_delay = 0;
-  // format_ctx->probesize = 64;
-
   /* frames per second */
   c->time_base = AVRational{.num = 1, .den = fps};
   c->framerate = AVRational{.num = fps, .den = 1};
-  c->pix_fmt = AV_PIX_FMT_RGB24;
-
-  c->gop_size = 10; /* emit one intra frame every ten frames */
-  c->max_b_frames = 1;
-  // c->pix_fmt = AV_PIX_FMT_YUV420P;
-
-  av_opt_set(c->priv_data, "preset", "superfast", 0);
-  av_opt_set(c->priv_data, "tune", "zerolatency", 0);
-
-  c->bit_rate_tolerance = 1000000;
-  // c->bit_rate = bitrate;
-  // c->delay = 0;
-  // c->thread_count = 1;
-  // c->gop_size = 0;
-
-  // preset: ultrafast, superfast, veryfast, faster, fast,
-  // medium, slow, slower, veryslow, placebo
-  // av_opt_set(pCodecCtx->priv_data,"preset","slow",0);
-  // tune: film, animation, grain, stillimage, psnr,
-  // ssim, fastdecode, zerolatency
-  // av_opt_set(pCodecCtx->priv_data,"tune","zerolatency",0);
-  // profile: baseline, main, high, high10, high422, high444
-  // av_opt_set(pCodecCtx->priv_data,"profile","main",0);
+  c->pix_fmt = pix_fmt;
+}
 
-  //
-  /* open it */
+void LibAVEncoder::open() {
+  if (!c || !pkt)
+    return;
   if (avcodec_open2(c, codec, NULL) < 0) {
     spdlog::error("Could not open codec");
     return;
@@ -75,31 +71,31 @@ Encoder::Encoder(unsigned bitrate, unsigned width, unsigned height, int fps) :
   frame->format = c->pix_fmt;
   frame->width = c->width;
   frame->height = c->height;
-  // avpicture_fill((AVPicture*)frame, NULL, frame->format, frame->width, frame->height);
-
-  // int ret = av_frame_get_buffer(frame, 32);
-  // if (ret < 0) {
-  //     fprintf(stderr, "could not alloc the frame data\n");
-  //     return;
-  // }
+  // RGB frames point to the input buffer, YUV frames own the converted planes
+  if (c->pix_fmt != AV_PIX_FMT_RGB24 && av_frame_get_buffer(frame, 32) < 0) {
+    spdlog::error("Could not allocate the frame data");
+    return;
+  }
   ready = true;
 
   // printf("Has a latency of %d frames\n", c->delay);
 }
 
-std::vector<uint8_t> Encoder::encode(uint8_t *buffer) {
-  if (!ready) return {};
-  av_image_fill_arrays(frame->data, frame->linesize, buffer, AV_PIX_FMT_RGB24, frame->width,
-                       frame->height, 1);
-  // av_image_copy(frame->data, frame->linesize, (const uint8_t **) &buffer, frame->linesize,
-  // AV_PIX_FMT_RGB24, frame->width, frame->height); av_image_copy        (uint8_t *dst_data[4], int
-  // dst_linesizes[4], const uint8_t *src_data[4], const int src_linesizes[4], enum AVPixelFormat
-  // pix_fmt, int width, int height) av_image_fill_arrays (uint8_t *dst_data[4], int
-  // dst_linesize[4],   uint8_t *src, enum AVPixelFormat pix_fmt, int width, int height, int align)
-  //
-
-  // frame->extended_data = &buffer;
-  // memcpy(frame->extended_data[0], buffer, frame->width * frame->height);
+PacketPtr LibAVEncoder::encode(const FramePtr &input) {
+  if (!ready) return nullptr;
+  const uint8_t *buffer = input->data();
+  if (c->pix_fmt == AV_PIX_FMT_YUV420P) {
+    // The encoder may still reference the previous frame
+    if (av_frame_make_writable(frame) < 0) {
+      spdlog::error("Frame not writable");
+      return nullptr;
+    }
+    rgb_to_yuv420p(buffer, frame->width, frame->height, frame->data[0], frame->linesize[0],
+                   frame->data[1], frame->linesize[1], frame->data[2], frame->linesize[2]);
+  } else {
+    av_image_fill_arrays(frame->data, frame->linesize, buffer, AV_PIX_FMT_RGB24, frame->width,
+                         frame->height, 1);
+  }
 
   frame->pts = seq;
   seq++;
@@ -108,31 +104,96 @@ std::vector<uint8_t> Encoder::encode(uint8_t *buffer) {
   ret = avcodec_send_frame(c, frame);
   if (ret < 0) {
     spdlog::error("error sending a frame for encoding");
-    return {};
+    return nullptr;
   }
-  av_packet_unref(pkt);
-  while (ret >= 0) {
-    ret = avcodec_receive_packet(c, pkt);
-    if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-      // fprintf(stderr, "ret error %d %d %d\n", ret, AVERROR(EAGAIN), AVERROR_EOF);
-      return {};
-    } else if (ret < 0) {
-      spdlog::error("error during encoding");
-      return {};
-    }
-    // printf("encoded frame %3" PRId64" %lld (size=%5d) %d \n", pkt->pts, pkt->dts, pkt->size,
-    // seq);
-    std::vector<uint8_t> buffer;
-    buffer.reserve(pkt->size);
-    std::copy(pkt->data, pkt->data + pkt->size, std::back_inserter(buffer));
-    return buffer;
-    // return std::vector<unsigned char>(pkt->data, pkt->data+pkt->size);
+  ret = avcodec_receive_packet(c, pkt);
+  if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+    return nullptr;
+  } else if (ret < 0) {
+    spdlog::error("error during encoding");
+    return nullptr;
   }
-  return {};
+  // Moves the reference to the buffer out of `pkt`
+  return std::make_shared<AVPacketRef>(pkt);
 }
 
-Encoder::~Encoder() {
+LibAVEncoder::~LibAVEncoder() {
   if (c) avcodec_free_context(&c);
   if (frame) av_frame_free(&frame);
   if (pkt) av_packet_free(&pkt);
 }
+
+H264Encoder::H264Encoder(unsigned bitrate, unsigned width, unsigned height, int fps,
+                         Format format, Profile profile)
+    : LibAVEncoder(format == yuv420p ? "libx264" : "libx264rgb", bitrate, width, height, fps,
+                   format == yuv420p ? AV_PIX_FMT_YUV420P : AV_PIX_FMT_RGB24) {
+  spdlog::info("Initializing an H264 encoder with input ({}, {}), fps {}, bitrate {}, {} output "
+               "and {} profile", width, height, fps, bitrate,
+               format == yuv420p ? "yuv420p" : "rgb24",
+               profile == low_latency ? "low latency" : "standard");
+  if (!c)
+    return;
+  if (profile == low_latency) {
+    // B-frames add at least one frame of delay and IDR frames are ~10x larger than the others:
+    // instead, a column of intra blocks sweeps the picture once per second. The VBV caps each
+    // frame to about bitrate / fps.
+    c->gop_size = fps;
+    c->max_b_frames = 0;
+    c->rc_max_rate = bitrate;
+    c->rc_buffer_size = bitrate / fps;
+  } else {
+    c->gop_size = 10; /* emit one intra frame every ten frames */
+    c->max_b_frames = 1;
+  }
+
+  av_opt_set(c->priv_data, "preset", "superfast", 0);
+  av_opt_set(c->priv_data, "tune", "zerolatency", 0);
+  if (profile == low_latency) {
+    av_opt_set(c->priv_data, "intra-refresh", "1", 0);
+    // NAL units that fit in a datagram [bytes]
+    av_opt_set(c->priv_data, "x264-params", "slice-max-size=1200", 0);
+  }
+
+  // preset: ultrafast, superfast, veryfast, faster, fast,
+  // medium, slow, slower, veryslow, placebo
+  // av_opt_set(pCodecCtx->priv_data,"preset","slow",0);
+  // tune: film, animation, grain, stillimage, psnr,
+  // ssim, fastdecode, zerolatency
+  // av_opt_set(pCodecCtx->priv_data,"tune","zerolatency",0);
+  // profile: baseline, main, high, high10, high422, high444
+  // av_opt_set(pCodecCtx->priv_data,"profile","main",0);
+  open();
+}
+
+bool H264Encoder::set_bitrate(unsigned bitrate) {
+  if (!c)
+    return false;
+  // libavcodec reconfigures libx264 when these change, before encoding the next frame
+  c->bit_rate = bitrate;
+  if (c->rc_max_rate) {
+    c->rc_max_rate = bitrate;
+    c->rc_buffer_size = static_cast<int>(int64_t(bitrate) * c->framerate.den / c->framerate.num);
+  }
+  return true;
+}
+
+MJPEGEncoder::MJPEGEncoder(unsigned bitrate, unsigned width, unsigned height, int fps)
+    : LibAVEncoder("mjpeg", bitrate, width, height, fps, AV_PIX_FMT_YUV420P) {
+  spdlog::info("Initializing an MJPEG encoder with input ({}, {}), fps {} and bitrate {}", width,
+               height, fps, bitrate);
+  if (!c)
+    return;
+  // `rgb_to_yuv420p` gives limited range YUV, which JPEG supports only as an extension
+  c->color_range = AVCOL_RANGE_MPEG;
+  c->strict_std_compliance = FF_COMPLIANCE_UNOFFICIAL;
+  open();
+}
+
+RawEncoder::RawEncoder(unsigned width, unsigned height) {
+  spdlog::info("Initializing a raw encoder with input ({}, {})", width, height);
+}
+
+PacketPtr RawEncoder::encode(const FramePtr &frame) {
+  // No copy: the frame goes back to the pool once sent
+  return std::make_shared<FramePacket>(frame);
+}
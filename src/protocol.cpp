@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstdint>
 #include <vector>
 
@@ -106,28 +107,32 @@ std::vector<uint8_t> discovery_message(bool is_pairing, const std::array<uint8_t
 
 
 std::vector<uint8_t> ResponseT::encode_msg(uint8_t set, uint8_t id) {
+  std::vector<uint8_t> buffer;
+  encode_msg(set, id, encode(), &buffer);
+  return buffer;
+}
+
+void ResponseT::encode_msg(uint8_t set, uint8_t id, const std::vector<uint8_t> &payload,
+                           std::vector<uint8_t> *buffer) {
   // TODO(Jerome): do I need to treat differently the request/no-ack case?
-  auto payload = encode();
   // spdlog::debug("Payload of size {}", payload.size());
   size_t len = 13 + payload.size();
-  std::vector<uint8_t> buffer(len, 0);
-  buffer[0] = 0x55;
-  buffer[1] = len & 0xff;
-  buffer[2] = ((len >> 8) & 0x3) | 4;
-  buffer[3] = crc8_calc(buffer.data(), 3);
-  buffer[4] = sender;
-  buffer[5] = receiver;
-  buffer[6] = seq_id & 0xff;
-  buffer[7] = (seq_id >> 8) & 0xff;
-  buffer[8] = attri();
-  buffer[9] = set;
-  buffer[10] = id;
-  for (size_t i = 0; i < payload.size(); i++) {
-    buffer[11 + i] = payload[i];
-  }
-  uint16_t crc_m = crc16_calc(buffer.data(), len - 2);
-  write<uint16_t>(buffer, len - 2, crc_m);
-  return buffer;
+  buffer->resize(len);
+  uint8_t *data = buffer->data();
+  data[0] = 0x55;
+  data[1] = len & 0xff;
+  data[2] = ((len >> 8) & 0x3) | 4;
+  data[3] = crc8_calc(data, 3);
+  data[4] = sender;
+  data[5] = receiver;
+  data[6] = seq_id & 0xff;
+  data[7] = (seq_id >> 8) & 0xff;
+  data[8] = attri();
+  data[9] = set;
+  data[10] = id;
+  std::copy(payload.begin(), payload.end(), data + 11);
+  uint16_t crc_m = crc16_calc(data, len - 2);
+  write<uint16_t>(*buffer, len - 2, crc_m);
 }
 
 bool decode_request(const uint8_t *buffer, size_t length, uint8_t *cmd_set, uint8_t *cmd_id,
@@ -0,0 +1,211 @@
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include "dummy_robot.hpp"
+#include "robomaster.hpp"
+#include "spdlog/spdlog.h"
+
+// Replays the requests recorded in a pcap trace (e.g., `tcpdump -i lo -w trace.pcap udp`)
+// against a dummy robot, stepping the simulation according to the recorded timestamps.
+
+struct Datagram {
+  double time;
+  unsigned short port;
+  unsigned short sender_port;
+  std::vector<uint8_t> data;
+};
+
+static uint32_t read_u32(const uint8_t *buffer, bool swapped) {
+  uint32_t value = read<uint32_t>(buffer);
+  return swapped ? __builtin_bswap32(value) : value;
+}
+
+static uint16_t read_u16_be(const uint8_t *buffer) { return (buffer[0] << 8) | buffer[1]; }
+
+// Returns the offset of the IPv4 header in a link-layer frame, or -1 if not IPv4
+static int ip_offset(uint32_t link_type, const uint8_t *frame, size_t length) {
+  switch (link_type) {
+  case 0:  // BSD loopback
+  case 108:
+    return length >= 4 ? 4 : -1;
+  case 1: {  // Ethernet
+    size_t offset = 12;
+    if (length < offset + 2)
+      return -1;
+    uint16_t ether_type = read_u16_be(frame + offset);
+    if (ether_type == 0x8100) {
+      offset += 4;
+      if (length < offset + 2)
+        return -1;
+      ether_type = read_u16_be(frame + offset);
+    }
+    return ether_type == 0x0800 ? offset + 2 : -1;
+  }
+  case 101:  // Raw IP
+    return 0;
+  case 113:  // Linux cooked capture
+    return (length >= 16 && read_u16_be(frame + 14) == 0x0800) ? 16 : -1;
+  case 276:  // Linux cooked capture v2
+    return (length >= 20 && read_u16_be(frame) == 0x0800) ? 20 : -1;
+  default:
+    return -1;
+  }
+}
+
+static bool read_pcap(const std::string &path, std::vector<Datagram> &datagrams) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    spdlog::error("Could not open {}", path);
+    return false;
+  }
+  std::vector<uint8_t> content((std::istreambuf_iterator<char>(file)),
+                               std::istreambuf_iterator<char>());
+  if (content.size() < 24) {
+    spdlog::error("{} is not a pcap file", path);
+    return false;
+  }
+  uint32_t magic = read<uint32_t>(content.data());
+  bool swapped;
+  double time_unit;
+  if (magic == 0xa1b2c3d4 || magic == 0xd4c3b2a1) {
+    swapped = (magic == 0xd4c3b2a1);
+    time_unit = 1e-6;
+  } else if (magic == 0xa1b23c4d || magic == 0x4d3cb2a1) {
+    swapped = (magic == 0x4d3cb2a1);
+    time_unit = 1e-9;
+  } else {
+    spdlog::error("{} is not a pcap file (pcapng is not supported)", path);
+    return false;
+  }
+  uint32_t link_type = read_u32(content.data() + 20, swapped) & 0xFFFF;
+  size_t offset = 24;
+  while (offset + 16 <= content.size()) {
+    const uint8_t *record = content.data() + offset;
+    double time = read_u32(record, swapped) + time_unit * read_u32(record + 4, swapped);
+    size_t length = read_u32(record + 8, swapped);
+    offset += 16;
+    if (offset + length > content.size())
+      break;
+    const uint8_t *frame = content.data() + offset;
+    offset += length;
+    int ip = ip_offset(link_type, frame, length);
+    if (ip < 0 || length < ip + 20u)
+      continue;
+    const uint8_t *ip_header = frame + ip;
+    size_t ip_header_length = 4 * (ip_header[0] & 0xF);
+    // Skip non-UDP and fragmented packets
+    if ((ip_header[0] >> 4) != 4 || ip_header[9] != 17 || (read_u16_be(ip_header + 6) & 0x3FFF))
+      continue;
+    if (length < ip + ip_header_length + 8)
+      continue;
+    const uint8_t *udp_header = ip_header + ip_header_length;
+    size_t udp_length = read_u16_be(udp_header + 4);
+    if (udp_length < 8 || length < ip + ip_header_length + udp_length)
+      continue;
+    datagrams.push_back({time, read_u16_be(udp_header + 2), read_u16_be(udp_header),
+                         std::vector<uint8_t>(udp_header + 8, udp_header + udp_length)});
+  }
+  spdlog::info("Loaded {} UDP datagrams from {}", datagrams.size(), path);
+  return true;
+}
+
+static void show_usage(std::string name) {
+  std::cout << "Usage: " << name << " <option(s)> <trace.pcap>" << std::endl
+            << "Options:" << std::endl
+            << "  --help\t\t\tShow this help message" << std::endl
+            << "  --log_level=<LEVEL>\t\tLog level (default: warn)" << std::endl
+            << "  --ip=<IP>\t\t\tRobot ip (default: 127.0.0.1)" << std::endl
+            << "  --sink=<IP>\t\t\tWhere to send responses and pushes (default: 127.0.0.1)"
+            << std::endl
+            << "  --period=<PERIOD>\t\tUpdate step [s] (default: 0.05)" << std::endl
+            << "  --real_time\t\t\tPace the replay like the recording (default: as fast as possible)"
+            << std::endl;
+}
+
+int main(int argc, char **argv) {
+  char log_level[100] = "warn";
+  char ip[100] = "127.0.0.1";
+  char sink[100] = "127.0.0.1";
+  float period = 0.05;
+  bool real_time = false;
+  std::string path;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--help") == 0) {
+      show_usage(argv[0]);
+      return 0;
+    }
+    if (strcmp(argv[i], "--real_time") == 0) {
+      real_time = true;
+      continue;
+    }
+    if (sscanf(argv[i], "--log_level=%99s", log_level)) {
+      continue;
+    }
+    if (sscanf(argv[i], "--ip=%99s", ip)) {
+      continue;
+    }
+    if (sscanf(argv[i], "--sink=%99s", sink)) {
+      continue;
+    }
+    if (sscanf(argv[i], "--period=%f", &period)) {
+      continue;
+    }
+    path = argv[i];
+  }
+  if (path.empty() || period <= 0) {
+    show_usage(argv[0]);
+    return 1;
+  }
+  spdlog::set_level(spdlog::level::from_str(log_level));
+  std::vector<Datagram> datagrams;
+  if (!read_pcap(path, datagrams) || datagrams.empty()) {
+    return 1;
+  }
+
+  auto io_context = std::make_shared<boost::asio::io_context>();
+  DummyRobot dummy(true, true, {true, true, false}, true, true, true);
+  RoboMaster robot(io_context, &dummy, "RM0001", false, DEFAULT_BITRATE, ip);
+  const auto sink_address = ba::ip::address::from_string(sink);
+
+  using clock = std::chrono::steady_clock;
+  const double t0 = datagrams.front().time;
+  const double duration = datagrams.back().time - t0;
+  size_t injected = 0;
+  size_t steps = 0;
+  double busy = 0.0;
+  double max_step = 0.0;
+  auto it = datagrams.cbegin();
+  const auto start = clock::now();
+  for (double sim_time = 0.0; sim_time <= duration + period; sim_time = steps * period) {
+    if (real_time) {
+      std::this_thread::sleep_until(start + std::chrono::duration<double>(sim_time));
+    }
+    const auto step_start = clock::now();
+    for (; it != datagrams.cend() && it->time - t0 <= sim_time; ++it) {
+      udp::endpoint sender(sink_address, it->sender_port);
+      if (robot.inject(it->port, it->data.data(), it->data.size(), sender)) {
+        injected++;
+      }
+    }
+    dummy.do_step(period);
+    io_context->poll();
+    const double step_duration = std::chrono::duration<double>(clock::now() - step_start).count();
+    busy += step_duration;
+    max_step = std::max(max_step, step_duration);
+    steps++;
+  }
+  const double wall = std::chrono::duration<double>(clock::now() - start).count();
+  spdlog::set_level(spdlog::level::info);
+  robot.dump_topic_stats();
+  spdlog::info("Replayed {} requests ({} datagrams ignored) over {} steps [{:.3f} s simulated]",
+               injected, datagrams.size() - injected, steps, steps * period);
+  spdlog::info("Wall time {:.3f} s: {:.1f} steps/s, {:.1f} requests/s, step time avg {:.3f} ms, "
+               "max {:.3f} ms",
+               wall, steps / wall, injected / wall, 1000 * busy / steps, 1000 * max_step);
+  return 0;
+}
@@ -31,9 +31,11 @@ RoboMaster::RoboMaster(std::shared_ptr<boost::asio::io_context> _io_context, Rob
                        bool enable_armor_hits, bool enable_ir_hits, const std::string app_id)
     : io_context(_io_context ? _io_context : std::make_shared<boost::asio::io_context>())
     , robot(_robot)
-    , discovery(io_context.get(), pad_serial(serial_number), ip, prefix_len, 1.0, app_id)
+    , scheduler()
+    , discovery(io_context.get(), &scheduler, pad_serial(serial_number), ip, prefix_len, 1.0, app_id)
     , conn(io_context.get(), robot, ip, 30030)
-    , cmds(io_context.get(), robot, this, ip, 20020, enable_armor_hits, enable_ir_hits) {
+    , cmds(io_context.get(), robot, this, ip, 20020, enable_armor_hits, enable_ir_hits)
+    , t(nullptr) {
   // spdlog::set_level(spdlog::level::info);
   video = VideoStreamer::create_video_streamer(io_context.get(), robot, ip, udp_video_stream,
                                                video_stream_bitrate);
@@ -44,12 +46,25 @@ RoboMaster::RoboMaster(std::shared_ptr<boost::asio::io_context> _io_context, Rob
 }
 
 void RoboMaster::do_step(float time_step) {
-  discovery.do_step(time_step);
+  scheduler.do_step(time_step);
   cmds.do_step(time_step);
   if (video)
     video->do_step(time_step);
 }
 
+bool RoboMaster::inject(unsigned short port, const uint8_t *buffer, size_t length,
+                        const udp::endpoint &sender) {
+  if (port == conn.local_endpoint().port()) {
+    conn.inject(buffer, length, sender);
+    return true;
+  }
+  if (port == cmds.local_endpoint().port()) {
+    cmds.inject(buffer, length, sender);
+    return true;
+  }
+  return false;
+}
+
 void RoboMaster::spin(bool thread) {
   if (thread) {
     spdlog::info("Start IO spinning in thread");
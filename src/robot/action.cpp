@@ -1,37 +1,105 @@
+#include <cmath>
+#include <limits>
+
 #include "robot/robot.hpp"
 
+TrapezoidalProfile::TrapezoidalProfile(float _max_speed, float _acceleration)
+    : max_speed(_max_speed)
+    , acceleration(_acceleration) {
+  if (max_speed * max_speed >= acceleration) {
+    // Does not reach the maximal speed
+    ramp_duration = std::sqrt(1.0f / acceleration);
+    max_speed = acceleration * ramp_duration;
+    duration = 2 * ramp_duration;
+  } else {
+    ramp_duration = max_speed / acceleration;
+    duration = ramp_duration + 1.0f / max_speed;
+  }
+}
+
+float TrapezoidalProfile::position(float time) const {
+  if (time <= 0)
+    return 0.0f;
+  if (time >= duration)
+    return 1.0f;
+  if (time < ramp_duration)
+    return 0.5f * acceleration * time * time;
+  if (time < duration - ramp_duration)
+    return 0.5f * max_speed * ramp_duration + max_speed * (time - ramp_duration);
+  const float left = duration - time;
+  return 1.0f - 0.5f * acceleration * left * left;
+}
+
+MoveAction::MoveAction(Robot *robot, Pose2D goal_pose, float _linear_speed, float _angular_speed)
+    : Action(robot)
+    , goal(goal_pose)
+    , start()
+    , linear_speed(_linear_speed)
+    , angular_speed(_angular_speed)
+    , profile()
+    , elapsed(0.0f) {
+  // The profile of the fraction of the motion done: the tighter of the linear and angular limits.
+  // Like the real robot, we do not normalize the angle.
+  const float distance = goal.distance();
+  const float angle = std::abs(goal.theta);
+  float max_speed = std::numeric_limits<float>::infinity();
+  float acceleration = std::numeric_limits<float>::infinity();
+  if (distance > 0) {
+    max_speed = std::min(max_speed, linear_speed / distance);
+    acceleration = std::min(acceleration, linear_acceleration / distance);
+  }
+  if (angle > 0) {
+    max_speed = std::min(max_speed, angular_speed / angle);
+    acceleration = std::min(acceleration, angular_acceleration / angle);
+  }
+  if (!(distance > 0 || angle > 0)) {
+    profile.duration = 0.0f;
+  } else if (max_speed > 0) {
+    profile = TrapezoidalProfile(max_speed, acceleration);
+  } else {
+    // Fails at start
+    profile.duration = std::numeric_limits<float>::infinity();
+  }
+  predicted_duration = remaining_duration = std::isfinite(profile.duration) ? profile.duration : 0;
+}
+
 void MoveAction::do_step(float time_step) {
-  bool first = false;
   if (state == Action::State::started) {
-    first = true;
-    goal_odom = robot->chassis.get_pose() * goal;
+    if (!std::isfinite(profile.duration)) {
+      spdlog::warn("Move Action with null speed: cannot reach {}", goal);
+      state = Action::State::failed;
+      return;
+    }
+    start = robot->chassis.get_pose();
+    elapsed = 0.0f;
     state = Action::State::running;
-    spdlog::info("Start Move Action to {} [odom]", goal_odom);
+    spdlog::info("Start Move Action to {} [odom] in {:.2f} s", start * goal, profile.duration);
   }
   if (state == Action::State::running) {
-    Pose2D goal = goal_odom.relative_to(robot->chassis.get_pose());
-    // Real robomaster is not normalizing!
-    // goal.theta = normalize(goal.theta);
-    spdlog::debug("Update Move Action to {} [frame] from {} [odom]", goal,
-                  robot->chassis.get_pose());
-    const float tau = 0.5f;
-    Twist2D twist;
-    if (goal.norm() < 0.01) {
-      twist = {0, 0, 0};
+    // Where we are and where we should be, in the frame of the robot at the start
+    const Pose2D current = robot->chassis.get_pose().relative_to(start);
+    const float s = profile.position(elapsed);
+    Twist2D error = {s * goal.x - current.x, s * goal.y - current.y,
+                     normalize(s * goal.theta - current.theta)};
+    const float distance_to_goal = std::hypot(error.x, error.y) + std::abs(error.theta);
+    // (up to rounding errors in `elapsed`)
+    if (elapsed > profile.duration - 0.5f * time_step && distance_to_goal < 0.01) {
+      robot->chassis.set_target_velocity({0, 0, 0});
       state = Action::State::succeed;
       remaining_duration = 0;
-      spdlog::info("Move Action done", goal);
-    } else {
-      float f = std::min(1.0f, linear_speed / (goal.distance() / tau));
-      twist = {f * goal.x / tau, f * goal.y / tau,
-               std::clamp(goal.theta / tau, -angular_speed, angular_speed)};
-      remaining_duration = time_to_goal(goal, linear_speed, angular_speed);
-      if (first)
-        predicted_duration = remaining_duration;
-      spdlog::debug("Move Action continue [{:.2f} s / {:.2f} s]", remaining_duration,
-                    predicted_duration);
+      spdlog::info("Move Action done in {:.2f} s", elapsed);
+      return;
     }
-    // current = goal;
+    // The mean velocity along the profile during the next step, plus a correction
+    const float ds = (profile.position(elapsed + time_step) - s) / time_step;
+    Twist2D twist = {ds * goal.x + gain * error.x, ds * goal.y + gain * error.y,
+                     ds * goal.theta + gain * error.theta};
+    // in the current frame of the robot
+    twist = twist.rotate_around_z(-current.theta);
+    elapsed += time_step;
+    remaining_duration = std::max(0.0f, profile.duration - elapsed);
+    spdlog::debug("Move Action continue [{:.2f} s / {:.2f} s]", remaining_duration,
+                  predicted_duration);
     robot->chassis.set_target_velocity(twist);
   }
 }
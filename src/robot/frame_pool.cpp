@@ -0,0 +1,63 @@
+#include <new>
+
+#include "spdlog/spdlog.h"
+
+#include "robot/frame_pool.hpp"
+
+CameraFrame::CameraFrame()
+    : width(0)
+    , height(0)
+    , buffer(nullptr)
+    , capacity(0) {}
+
+CameraFrame::~CameraFrame() {
+  if (buffer)
+    ::operator delete(buffer, std::align_val_t{alignment});
+}
+
+void CameraFrame::resize(unsigned _width, unsigned _height) {
+  width = _width;
+  height = _height;
+  if (size() <= capacity)
+    return;
+  if (buffer)
+    ::operator delete(buffer, std::align_val_t{alignment});
+  capacity = size();
+  buffer = static_cast<uint8_t *>(::operator new(capacity, std::align_val_t{alignment}));
+}
+
+FramePool::FramePool(size_t _max_number_of_frames)
+    : storage(std::make_shared<Storage>())
+    , max_number_of_frames(_max_number_of_frames) {
+  storage->number_of_frames = 0;
+  storage->leased = 0;
+}
+
+FramePtr FramePool::lease(unsigned width, unsigned height) {
+  std::unique_ptr<CameraFrame> frame;
+  {
+    std::lock_guard<std::mutex> lock(storage->mutex);
+    if (!storage->free_frames.empty()) {
+      frame = std::move(storage->free_frames.back());
+      storage->free_frames.pop_back();
+    } else if (storage->number_of_frames < max_number_of_frames) {
+      frame = std::make_unique<CameraFrame>();
+      storage->number_of_frames++;
+    } else {
+      spdlog::debug("[FramePool] All {} frames are in use", max_number_of_frames);
+      return nullptr;
+    }
+    storage->leased++;
+  }
+  frame->resize(width, height);
+  return FramePtr(frame.release(), [storage = storage](CameraFrame *frame) {
+    std::lock_guard<std::mutex> lock(storage->mutex);
+    storage->free_frames.emplace_back(frame);
+    storage->leased--;
+  });
+}
+
+size_t FramePool::leased() const {
+  std::lock_guard<std::mutex> lock(storage->mutex);
+  return storage->leased;
+}
@@ -82,7 +82,8 @@ void ActiveLED::do_step(float time_step) {
 
 CompositeLED::CompositeLED(size_t number)
     : ActiveLED::ActiveLED()
-    , number(number) {}
+    , number(std::min(number, max_number))
+    , colors() {}
 
 void CompositeLED::update(Color _color, LedEffect _effect, float _period_1, float _period_2,
                           bool _loop, CompositeLedMask _led_mask) {
@@ -98,7 +99,7 @@ void CompositeLED::update(Color _color, LedEffect _effect, float _period_1, floa
       }
     }
   } else {
-    colors.clear();
+    colors.fill({});
     _led_mask = 0xFF;
   }
   changed = _led_mask;
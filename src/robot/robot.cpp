@@ -20,11 +20,17 @@ Robot::Robot(bool _has_arm, bool _has_gripper, ServoValues<bool> _has_servo, boo
     , has_camera(_has_camera)
     , has_tof(_has_tof)
     , connected_servos()
+    , connected_servo_mask(0)
     , mode(Mode::FREE)
     , sdk_enabled(false)
     , time_(0.0f)
     , callbacks()
-    , actions() {
+    , actions()
+    , active_actions(0)
+    , queued_actions() {
+  previous_action_state.fill(Action::State::undefined);
+  action_policies.fill(Action::Policy::reject);
+  max_queue_lengths.fill(0);
   for (size_t i = 0; i < has_servo.size(); i++) {
     if (has_servo[i])
       connected_servos[i] = &servos[i];
@@ -33,6 +39,10 @@ Robot::Robot(bool _has_arm, bool _has_gripper, ServoValues<bool> _has_servo, boo
     connected_servos[3] = &gimbal.yaw_servo;
     connected_servos[4] = &gimbal.pitch_servo;
   }
+  for (size_t i = 0; i < connected_servos.size(); i++) {
+    if (connected_servos[i])
+      connected_servo_mask |= 1 << i;
+  }
   std::string modules = "";
   if (has_arm)
     modules += "arm ";
@@ -73,7 +83,8 @@ void Robot::control_servos() {
     arm.limit_motors(last_time_step);
   }
 #endif
-  for (auto const &[i, servo] : connected_servos) {
+  for (unsigned i : Bits(connected_servo_mask)) {
+    Servo *servo = connected_servos[i];
     if (servo->enabled.check()) {
       forward_servo_enabled(i, servo->enabled.target);
     }
@@ -129,8 +140,6 @@ void Robot::do_step(float time_step) {
   last_time_step = time_step;
 
   read_chassis();
-  read_hit_events();
-  read_ir_events();
   if (has_tof) {
     size_t index = 0;
     for (auto & tof_reading : tof.readings) {
@@ -150,7 +159,11 @@ void Robot::do_step(float time_step) {
     // Stream the camera image
     if (camera.streaming) {
       spdlog::debug("[Robot] capture new camera frame");
-      camera.image = read_camera_image();
+      // Release the previous frame first, so that the pool can reuse it
+      camera.image = nullptr;
+      auto frame = camera.pool.lease(camera.width, camera.height);
+      if (frame && read_camera_image(frame.get()))
+        camera.image = std::move(frame);
       // std::cout << int(image[0]) << " " << int(image[1]) << " " << int(image[2]) << " (" <<
       // image.size() <<")\n"; auto image = std::vector<unsigned char>(640 * 360 * 3, 0); auto image
       // = _image; static unsigned seq = 0; seq++; std::string name =
@@ -161,26 +174,26 @@ void Robot::do_step(float time_step) {
     }
   }
 
-  for (auto const &[i, servo] : connected_servos) {
-    servo->angle.current = read_servo_angle(i);
-    servo->speed.current = read_servo_speed(i);
+  for (unsigned i : Bits(connected_servo_mask)) {
+    connected_servos[i]->angle.current = read_servo_angle(i);
+    connected_servos[i]->speed.current = read_servo_speed(i);
   }
 
   if (has_arm) {
     arm.update_position();
   }
 
-  // Run Actions. Using iterators to safely delete a key.
-  auto it = actions.cbegin();
-  while (it != actions.cend()) {
-    it->second->do_step_cb(time_step);
-    if (it->second->done()) {
-      previous_action_state[it->first] = it->second->state;
-      it = actions.erase(it);
-    } else {
-      it++;
+  // Run Actions
+  std::unique_lock<std::mutex> action_lock(action_mutex);
+  for (unsigned kind : Bits(active_actions)) {
+    auto &action = actions[kind];
+    action->do_step_cb(time_step);
+    if (action->done()) {
+      previous_action_state[kind] = action->state;
+      start_next_action(static_cast<Action::Kind>(kind));
     }
   }
+  action_lock.unlock();
 
   if (has_gimbal) {
     gimbal.update_control(time_step, chassis.attitude, chassis.imu);
@@ -263,6 +276,40 @@ bool Robot::stop_streaming() {
   return true;
 }
 
+void Robot::set_action_policy(Action::Kind kind, Action::Policy policy, size_t max_queue_length) {
+  std::lock_guard<std::mutex> lock(action_mutex);
+  action_policies[kind] = policy;
+  max_queue_lengths[kind] = (policy == Action::Policy::queue) ? max_queue_length : 0;
+  // Actions already queued keep their place
+}
+
+void Robot::abort_actions(Action::Kind kind) {
+  if (actions[kind]) {
+    auto action = std::move(actions[kind]);
+    action->set_state(Action::State::failed);
+    previous_action_state[kind] = Action::State::failed;
+  }
+  active_actions &= ~(1 << kind);
+  auto queue = std::move(queued_actions[kind]);
+  queued_actions[kind].clear();
+  for (auto &action : queue) {
+    action->set_state(Action::State::failed);
+  }
+}
+
+void Robot::start_next_action(Action::Kind kind) {
+  auto &queue = queued_actions[kind];
+  if (queue.empty()) {
+    actions[kind] = nullptr;
+    active_actions &= ~(1 << kind);
+    return;
+  }
+  actions[kind] = std::move(queue.front());
+  queue.pop_front();
+  spdlog::info("[Robot] Start queued action of kind {} ({} waiting)", kind, queue.size());
+  actions[kind]->set_state(Action::State::started);
+}
+
 Action::State Robot::move_base(const Pose2D &pose, float linear_speed, float angular_speed) {
   auto a = std::make_unique<MoveAction>(this, pose, linear_speed, angular_speed);
   return submit_action(std::move(a));
@@ -292,14 +339,10 @@ Action::State Robot::move_gimbal(float target_yaw, float target_pitch, float yaw
 }
 
 Action::State Robot::submit_action(std::unique_ptr<MoveAction> action) {
-  // TODO(Jerome): What should we do if an action is already active?
-  if (actions.count("move"))
-    return Action::State::rejected;
-  // actions["move"] = std::move(action);
-  action->state = Action::State::started;
-  actions.emplace("move", std::move(action));
-  spdlog::info("Start new MoveAction");
-  return actions["move"]->state;
+  auto state = start_action(std::move(action));
+  if (state == Action::State::started)
+    spdlog::info("Start new MoveAction");
+  return state;
 }
 
 Action::State Robot::submit_action(std::unique_ptr<MoveArmAction> action) {
@@ -308,41 +351,29 @@ Action::State Robot::submit_action(std::unique_ptr<MoveArmAction> action) {
     spdlog::warn("Arm not connected: cannot do action");
     return Action::State::rejected;
   }
-  // TODO(Jerome): What should we do if an action is already active?
-  if (actions.count("move_arm"))
-    return Action::State::rejected;
-  // actions["move_arm"] = action;
-  action->state = Action::State::started;
-  actions.emplace("move_arm", std::move(action));
-  spdlog::info("Start new MoveArmAction");
-  return actions["move_arm"]->state;
+  auto state = start_action(std::move(action));
+  if (state == Action::State::started)
+    spdlog::info("Start new MoveArmAction");
+  return state;
 }
 
 Action::State Robot::submit_action(std::unique_ptr<PlaySoundAction> action) {
-  // TODO(Jerome): What should we do if an action is already active?
-  if (actions.count("play_sound"))
-    return Action::State::rejected;
-  // actions["play_sound"] = action;
-  action->state = Action::State::started;
-  actions.emplace("play_sound", std::move(action));
-  spdlog::info("Start new PlaySoundAction");
-  return actions["play_sound"]->state;
+  auto state = start_action(std::move(action));
+  if (state == Action::State::started)
+    spdlog::info("Start new PlaySoundAction");
+  return state;
 }
 
 Action::State Robot::submit_action(std::unique_ptr<MoveServoAction> action) {
-  // TODO(Jerome): What should we do if an action is already active?
-  if (action->servo_id > has_servo.size() || !has_servo[action->servo_id]) {
+  if (action->servo_id >= has_servo.size() || !has_servo[action->servo_id]) {
     // TODO(Jerome): check what happens with real robots
     spdlog::warn("Servo {} not connected: cannot do action", action->servo_id);
     return Action::State::rejected;
   }
-  if (actions.count("move_servo"))
-    return Action::State::rejected;
-  // actions["play_sound"] = action;
-  action->state = Action::State::started;
-  actions.emplace("move_servo", std::move(action));
-  spdlog::info("Start new MoveServoAction");
-  return actions["move_servo"]->state;
+  auto state = start_action(std::move(action));
+  if (state == Action::State::started)
+    spdlog::info("Start new MoveServoAction");
+  return state;
 }
 
 Action::State Robot::submit_action(std::unique_ptr<MoveGimbalAction> action) {
@@ -351,12 +382,8 @@ Action::State Robot::submit_action(std::unique_ptr<MoveGimbalAction> action) {
     spdlog::warn("Gimbal not connected: cannot do action");
     return Action::State::rejected;
   }
-  // TODO(Jerome): What should we do if an action is already active?
-  if (actions.count("move_gimbal"))
-    return Action::State::rejected;
-  // actions["move"] = std::move(action);
-  action->state = Action::State::started;
-  actions.emplace("move_gimbal", std::move(action));
-  spdlog::info("Start new MoveGimbalAction");
-  return actions["move_gimbal"]->state;
+  auto state = start_action(std::move(action));
+  if (state == Action::State::started)
+    spdlog::info("Start new MoveGimbalAction");
+  return state;
 }
@@ -0,0 +1,97 @@
+#include "spdlog/spdlog.h"
+
+#include "rt_topic.hpp"
+
+RealTimeTopic::RealTimeTopic(boost::asio::io_context *io_context, Commands *_server,
+                             Robot *_robot, const AddSubMsg::Request &_request,
+                             const std::vector<Subject *> &_subjects)
+    : Topic(_server, _robot, _request, _subjects)
+    , state(std::make_shared<State>())
+    , wall_timer(*io_context)
+    , period(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(1.0 / request.sub_freq))) {}
+
+void RealTimeTopic::start() {
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->active = true;
+  }
+  // Deadlines are absolute, so that delays in handling one push do not accumulate
+  wall_timer.expires_after(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(delay(now()))));
+  schedule();
+  spdlog::info("[Topic] Start {} @ {} Hz (real time)", name(), request.sub_freq);
+}
+
+void RealTimeTopic::stop() {
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (!state->active)
+      return;
+    state->active = false;
+  }
+  wall_timer.cancel();
+  spdlog::info("[Topic] Stop {}: {}", name(), stats.summary());
+}
+
+TopicReport RealTimeTopic::report() {
+  // The stats are updated by the IO thread
+  std::lock_guard<std::mutex> lock(state->mutex);
+  return Topic::report();
+}
+
+void RealTimeTopic::set_frequency(float value) {
+  std::lock_guard<std::mutex> lock(state->mutex);
+  frequency = value;
+  // Applies from the next push
+  period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(1.0 / frequency));
+}
+
+double RealTimeTopic::now() const {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void RealTimeTopic::sample() {
+  // Called by the simulation thread: the data of all subjects refer to the same step
+  const double time = now();
+  std::lock_guard<std::mutex> lock(state->mutex);
+  if (!should_push(time))
+    return;
+  state->snapshot = subject_data();
+  state->fresh = true;
+}
+
+void RealTimeTopic::schedule() {
+  std::shared_ptr<State> _state = state;
+  wall_timer.async_wait([this, _state](const boost::system::error_code &error) {
+    if (error)
+      return;
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    // `this` is valid as long as the topic is active
+    if (!_state->active)
+      return;
+    const auto time = std::chrono::steady_clock::now();
+    // Nothing to push before the first step. Without changes, repeat the last snapshot
+    // only as keepalive.
+    if (!_state->snapshot.empty() &&
+        (_state->fresh || std::chrono::duration<double>(time - _state->last_push).count() >=
+                              keepalive())) {
+      push(_state->snapshot);
+      _state->fresh = false;
+      _state->last_push = time;
+    } else if (!_state->snapshot.empty()) {
+      stats.skipped++;
+    }
+    // Skip the pushes missed while the IO thread was busy, instead of bursting them
+    auto next = wall_timer.expiry() + period;
+    if (next < time) {
+      const auto missed = (time - next) / period + 1;
+      stats.dropped += missed;
+      next += missed * period;
+    }
+    wall_timer.expires_at(next);
+    schedule();
+  });
+}
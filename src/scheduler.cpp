@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <cmath>
+
+#include "scheduler.hpp"
+
+Scheduler::Scheduler()
+    : wheel()
+    , occupied()
+    , expired()
+    , now(0)
+    , time(0.0) {}
+
+Scheduler::TimerPtr Scheduler::schedule(float period, Callback callback, float delay) {
+  uint64_t origin = now + std::max<int64_t>(0, std::llround(delay * ticks_per_second));
+  auto timer = std::make_shared<Timer>(callback, origin, period * ticks_per_second);
+  insert(timer);
+  return timer;
+}
+
+void Scheduler::insert(const TimerPtr &timer) {
+  if (timer->deadline <= now) {
+    expired.push_back(timer);
+    return;
+  }
+  uint64_t delta = timer->deadline - now;
+  unsigned level = 0;
+  while (level + 1 < number_of_levels && delta >= (uint64_t(1) << ((level + 1) * level_bits))) {
+    level++;
+  }
+  // Timers beyond the range of the top level are put back there when cascading
+  unsigned index = (timer->deadline >> (level * level_bits)) & slot_mask;
+  wheel[level][index].push_back(timer);
+  occupied[level] |= uint64_t(1) << index;
+}
+
+void Scheduler::cascade(unsigned level) {
+  if (level >= number_of_levels)
+    return;
+  unsigned index = (now >> (level * level_bits)) & slot_mask;
+  if (index == 0) {
+    cascade(level + 1);
+  }
+  if (!(occupied[level] & (uint64_t(1) << index)))
+    return;
+  Slot timers;
+  timers.swap(wheel[level][index]);
+  occupied[level] &= ~(uint64_t(1) << index);
+  for (auto &timer : timers) {
+    if (timer->active)
+      insert(timer);
+  }
+}
+
+void Scheduler::fire(Slot *slot) {
+  Slot timers;
+  timers.swap(*slot);
+  for (auto &timer : timers) {
+    if (!timer->active)
+      continue;
+    timer->callback();
+    if (!timer->active || timer->period <= 0)
+      continue;
+    timer->count++;
+    timer->deadline = timer->origin + std::llround(timer->count * timer->period);
+    insert(timer);
+  }
+}
+
+void Scheduler::fire_expired() {
+  // Timers with periods shorter than a step are called multiple times
+  while (!expired.empty()) {
+    fire(&expired);
+  }
+}
+
+void Scheduler::do_step(float time_step) {
+  time += time_step;
+  const uint64_t target = std::llround(time * ticks_per_second);
+  fire_expired();
+  while (now < target) {
+    // The next tick with timers in the current rotation of the lowest level,
+    // or the start of the next rotation.
+    const uint64_t offset = now & slot_mask;
+    const uint64_t pending = occupied[0] & ~((uint64_t(2) << offset) - 1);
+    const uint64_t next =
+        now - offset + (pending ? __builtin_ctzll(pending) : number_of_slots);
+    if (next > target) {
+      now = target;
+      break;
+    }
+    now = next;
+    const unsigned index = now & slot_mask;
+    if (index == 0) {
+      cascade(1);
+    }
+    if (occupied[0] & (uint64_t(1) << index)) {
+      occupied[0] &= ~(uint64_t(1) << index);
+      fire(&wheel[0][index]);
+    }
+    fire_expired();
+  }
+}
@@ -49,6 +49,11 @@ void Server::has_received_bytes(const uint8_t *raw_request, size_t length) {
   send(raw_response);
 }
 
+void Server::inject(const uint8_t *raw_request, size_t length, const udp::endpoint &sender) {
+  sender_endpoint_ = sender;
+  has_received_bytes(raw_request, length);
+}
+
 void Server::do_receive() {
   socket_.async_receive_from(boost::asio::buffer(data_, kMaxLength), sender_endpoint_,
                              [this](boost::system::error_code ec, std::size_t bytes_recvd) {
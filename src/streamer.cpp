@@ -1,3 +1,9 @@
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <utility>
+
+#include "spdlog/fmt/fmt.h"
 #include "spdlog/spdlog.h"
 
 #include "streamer.hpp"
@@ -7,17 +13,48 @@
 #define UDP_PORT 11111
 #define VIDEO_STREAMER_ALLOW_TCP false
 
+// Accepts any number of viewers (e.g., the client and a recorder), which receive the same
+// encoded frames through their own write queue.
 class TCPVideoStreamer final : public VideoStreamer {
  public:
   TCPVideoStreamer(ba::io_context *io_context, Robot *robot, std::string ip = "",
                    unsigned bitrate = DEFAULT_BITRATE);
 
  private:
+  // Above it, new frames are skipped until the next keyframe [bytes]
+  static constexpr size_t max_queued_bytes = 256 * 1024;
+  // Before accepting again after an error (e.g., too many open files)
+  static constexpr std::chrono::seconds accept_retry_period{1};
+
+  struct Viewer {
+    Viewer(ba::ip::tcp::socket _socket, const ba::ip::tcp::endpoint &_endpoint)
+        : socket(std::move(_socket))
+        , endpoint(_endpoint)
+        , queued_bytes(0)
+        , waiting_for_keyframe(true) {}
+    ba::ip::tcp::socket socket;
+    ba::ip::tcp::endpoint endpoint;
+    // Owned by the IO thread. The front frame is being written.
+    std::deque<std::shared_ptr<const EncodedFrame>> write_queue;
+    size_t queued_bytes;
+    bool waiting_for_keyframe;
+  };
+
   ba::ip::tcp::acceptor acceptor;
-  ba::ip::tcp::socket tcp_socket;
-  void send_buffer(ba::const_buffer &);
+  ba::steady_timer accept_timer;
+  // Like the write queues, used in the IO thread only
+  std::vector<std::shared_ptr<Viewer>> viewers;
+  bool accepting;
+  bool streaming;
+  void send_buffer(std::shared_ptr<const EncodedFrame> frame);
+  void send_to(const std::shared_ptr<Viewer> &viewer, std::shared_ptr<const EncodedFrame> frame);
+  void write_front(std::shared_ptr<Viewer> viewer);
+  void remove(const std::shared_ptr<Viewer> &viewer);
+  void update_queued_bytes();
+  void accept();
   void start_socket(const ba::ip::address &address);
   void stop_socket();
+  bool can_adapt_bitrate() const { return true; }
 };
 
 class UDPVideoStreamer final : public VideoStreamer {
@@ -26,9 +63,34 @@ class UDPVideoStreamer final : public VideoStreamer {
                    unsigned bitrate = DEFAULT_BITRATE);
 
  private:
+  // Payload that fits in an Ethernet MTU (1500 bytes), with room for IP options and tunnels
+  static constexpr size_t max_datagram_size = 1400;
+  static constexpr std::chrono::milliseconds pacing_period{1};
+
+  struct Datagram {
+    std::shared_ptr<const EncodedFrame> frame;
+    size_t offset;
+    size_t size;
+    // Of its frame
+    bool last;
+  };
+
+  // Used in the IO thread only
   ba::ip::udp::socket udp_socket;
   ba::ip::udp::endpoint udp_endpoint;
-  void send_buffer(ba::const_buffer &);
+  ba::steady_timer pacing_timer;
+  std::deque<Datagram> datagrams;
+  // Datagrams to send every `pacing_period`
+  size_t burst_size;
+  // Of the datagrams [bytes]
+  size_t queued_bytes;
+  bool pacing;
+  // Whether to split frames before each H.264 NAL unit
+  bool split_nal_units;
+  // Over which the datagrams of a frame are spread
+  std::chrono::duration<double> pacing_interval;
+  void send_buffer(std::shared_ptr<const EncodedFrame> frame);
+  void send_datagrams();
   void start_socket(const ba::ip::address &address);
   void stop_socket();
 };
@@ -41,91 +103,492 @@ std::unique_ptr<VideoStreamer> VideoStreamer::create_video_streamer(ba::io_conte
   return std::make_unique<TCPVideoStreamer>(io_context, robot, ip, bitrate);
 }
 
-VideoStreamer::VideoStreamer(Robot *_robot, unsigned _bitrate)
-    : active(false)
+// Splits `data` in chunks of at most `max_size` bytes. If `annex_b` is set, it is an H.264 byte
+// stream: a new chunk starts at each start code, so that a lost chunk corrupts a single NAL unit.
+// Returns the offsets and sizes of the chunks.
+static std::vector<std::pair<size_t, size_t>> split(const uint8_t *data, size_t size,
+                                                    size_t max_size, bool annex_b) {
+  std::vector<std::pair<size_t, size_t>> chunks;
+  size_t begin = 0;
+  auto add_chunks = [&](size_t end) {
+    while (begin < end) {
+      const size_t length = std::min(max_size, end - begin);
+      chunks.emplace_back(begin, length);
+      begin += length;
+    }
+  };
+  if (annex_b) {
+    for (size_t i = 1; i + 2 < size; i++) {
+      if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+        // 4 bytes start codes begin with one more zero
+        add_chunks(data[i - 1] == 0 ? i - 1 : i);
+        i += 2;
+      }
+    }
+  }
+  add_chunks(size);
+  return chunks;
+}
+
+std::string VideoStats::summary() const {
+  return fmt::format("{} frames, {} dropped, {} encoded ({} bytes, {:.2f} ms/frame), {} sent "
+                     "({} bytes, latency avg/max {:.1f}/{:.1f} ms), {} skipped ({} bytes, "
+                     "at most {} bytes queued), bitrate {} bps",
+                     frames, dropped, encoded, encoded_bytes,
+                     encoded ? 1e3 * encode_time / encoded : 0.0, sent, sent_bytes,
+                     1e3 * latency(), 1e3 * latency_max, skipped, skipped_bytes,
+                     queued_bytes_max, bitrate);
+}
+
+std::string VideoStats::bitrate_summary() const {
+  std::string text;
+  for (const auto &sample : bitrate_history) {
+    text += fmt::format("{}{:.1f} s: {} bps ({} bytes queued, {:.1f} ms)",
+                        text.empty() ? "" : ", ", sample.time, sample.bitrate,
+                        sample.queued_bytes, 1e3 * sample.latency);
+  }
+  return text;
+}
+
+VideoStreamer::VideoStreamer(ba::io_context *_io_context, Robot *_robot, unsigned _bitrate)
+    : io_context(_io_context)
+    , active(false)
     , bitrate(_bitrate)
+    , fps(0)
     , robot(_robot)
-    , seq(0) {}
+    , encoder_bitrate(_bitrate)
+    , target_bitrate(_bitrate)
+    , backend(Encoder::x264)
+    , format(Encoder::rgb24)
+    , profile(Encoder::standard)
+    , seq(0)
+    , width(0)
+    , height(0)
+    , encoding(false)
+    , min_bitrate(0)
+    , max_bitrate(0)
+    , stream_min_bitrate(0)
+    , stream_max_bitrate(0)
+    , recent_backlog(0)
+    , recent_latency(0.0)
+    , recent_skipped(0) {}
 
-VideoStreamer::~VideoStreamer() {}
+VideoStreamer::~VideoStreamer() { stop_worker(); }
 
 void VideoStreamer::do_step(float time_step) {
   auto camera = robot->get_camera();
-  if (!camera->image.empty()) {
-    send(camera->image.data());
+  if (camera->image) {
+    send(camera->image);
   }
 }
 
-void VideoStreamer::send(uint8_t *buffer) {
+void VideoStreamer::send(FramePtr frame) {
   if (!active)
     return;
-  auto data = encoder->encode(buffer);
-  if (!data.empty()) {
-    spdlog::debug("[Video] Will send frame #{} ({} bytes)", seq++, data.size());
-    auto bbuffer = boost::asio::const_buffer(data.data(), data.size());
-    send_buffer(bbuffer);
+  std::unique_lock<std::mutex> lock(mutex);
+  if (!encoding)
+    return;
+  if (frame->width != width || frame->height != height) {
+    spdlog::warn("[Video] Skip frame of size ({}, {}) instead of ({}, {})", frame->width,
+                 frame->height, width, height);
+    return;
   }
+  stats.frames++;
+  if (frames.size() >= max_queued_frames) {
+    frames.pop_front();
+    stats.dropped++;
+  }
+  frames.push_back({std::move(frame), VideoClock::now()});
+  lock.unlock();
+  frame_ready.notify_one();
+}
+
+void VideoStreamer::encode_frames() {
+  std::unique_lock<std::mutex> lock(mutex);
+  for (;;) {
+    frame_ready.wait(lock, [this] { return !encoding || !frames.empty(); });
+    if (!encoding)
+      return;
+    QueuedFrame queued = std::move(frames.front());
+    frames.pop_front();
+    lock.unlock();
+    const auto begin = VideoClock::now();
+    const unsigned value = target_bitrate;
+    if (value != encoder_bitrate) {
+      // x264 changes its rate control on the fly. Other encoders start again, from a keyframe.
+      if (!encoder->set_bitrate(value))
+        encoder = create_encoder(value);
+      encoder_bitrate = value;
+    }
+    auto packet = encoder->encode(queued.frame);
+    queued.frame = nullptr;
+    const std::chrono::duration<double> duration = VideoClock::now() - begin;
+    const size_t size = packet ? packet->size() : 0;
+    if (size) {
+      spdlog::debug("[Video] Will send frame #{} ({} bytes)", seq, size);
+      auto encoded = std::make_shared<const EncodedFrame>(
+          EncodedFrame{std::move(packet), seq++, queued.submitted});
+      ba::post(*io_context, [this, encoded]() {
+        if (active)
+          send_buffer(encoded);
+      });
+    }
+    lock.lock();
+    stats.encoded++;
+    stats.encoded_bytes += size;
+    stats.encode_time += duration.count();
+  }
+}
+
+void VideoStreamer::stop_worker() {
+  if (!worker.joinable())
+    return;
+  std::unique_lock<std::mutex> lock(mutex);
+  encoding = false;
+  lock.unlock();
+  frame_ready.notify_one();
+  worker.join();
+  lock.lock();
+  frames.clear();
+  spdlog::info("[Video] {}", stats.summary());
+  if (!stats.bitrate_history.empty())
+    spdlog::info("[Video] Bitrate history: {}", stats.bitrate_summary());
+}
+
+void VideoStreamer::sent(const EncodedFrame &frame, size_t backlog) {
+  const std::chrono::duration<double> latency = VideoClock::now() - frame.submitted;
+  spdlog::debug("[Video] Sent frame #{} ({} bytes) {:.1f} ms after its submission", frame.seq,
+                frame.packet->size(), 1e3 * latency.count());
+  std::lock_guard<std::mutex> lock(mutex);
+  stats.sent++;
+  stats.latency_sum += latency.count();
+  stats.latency_max = std::max(stats.latency_max, latency.count());
+  stats.sent_bytes += frame.packet->size();
+  recent_backlog = std::max(recent_backlog, backlog);
+  recent_latency = std::max(recent_latency, latency.count());
+  adapt_bitrate(VideoClock::now());
+}
+
+void VideoStreamer::skipped(const EncodedFrame &frame, bool congested) {
+  spdlog::debug("[Video] Skipped frame #{} ({} bytes)", frame.seq, frame.packet->size());
+  std::lock_guard<std::mutex> lock(mutex);
+  stats.skipped++;
+  stats.skipped_bytes += frame.packet->size();
+  if (congested)
+    recent_skipped++;
+  adapt_bitrate(VideoClock::now());
+}
+
+void VideoStreamer::queued(size_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex);
+  stats.queued_bytes = bytes;
+  stats.queued_bytes_max = std::max(stats.queued_bytes_max, bytes);
+}
+
+void VideoStreamer::set_adaptive_bitrate(unsigned _min_bitrate, unsigned _max_bitrate) {
+  std::lock_guard<std::mutex> lock(mutex);
+  min_bitrate = std::min(_min_bitrate, _max_bitrate);
+  max_bitrate = _max_bitrate;
+  if (max_bitrate)
+    spdlog::info("[Video] Adapt the bitrate between {} and {} bps", min_bitrate, max_bitrate);
+}
+
+// Like TCP congestion control: decreases multiplicatively when congested, increases slowly
+// otherwise. The signals are the writes that complete: how many bytes still wait behind them and
+// how long after their submission they complete; and the frames skipped by congested viewers.
+void VideoStreamer::adapt_bitrate(VideoClock::time_point now) {
+  if (!stream_max_bitrate || now - last_adaptation < adaptation_period)
+    return;
+  last_adaptation = now;
+  const unsigned current = target_bitrate;
+  const double frame_interval = fps > 0 ? 1.0 / fps : 0.04;
+  // How long the bytes queued behind a write wait to be sent [s]. It excludes the frame being
+  // written, so that a large keyframe alone does not look like congestion.
+  const double delay = 8.0 * recent_backlog / std::max(current, 1u);
+  double value = current;
+  if (recent_skipped || delay > 4 * frame_interval || recent_latency > 8 * frame_interval) {
+    value *= 0.7;
+  } else if (delay < frame_interval && recent_latency < 4 * frame_interval) {
+    value *= 1.1;
+  }
+  const unsigned target = static_cast<unsigned>(std::clamp(
+      value, static_cast<double>(stream_min_bitrate), static_cast<double>(stream_max_bitrate)));
+  if (target != current) {
+    spdlog::info("[Video] Set bitrate to {} bps ({} bytes queued, latency {:.1f} ms, {} frames "
+                 "skipped)",
+                 target, recent_backlog, 1e3 * recent_latency, recent_skipped);
+    target_bitrate = target;
+  }
+  const std::chrono::duration<double> time = now - stream_start;
+  stats.bitrate = target;
+  stats.bitrate_history.push_back({time.count(), target, recent_backlog, recent_latency});
+  if (stats.bitrate_history.size() > max_bitrate_history)
+    stats.bitrate_history.pop_front();
+  recent_backlog = 0;
+  recent_latency = 0.0;
+  recent_skipped = 0;
+}
+
+VideoStats VideoStreamer::get_stats() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return stats;
 }
 
 void VideoStreamer::start(const ba::ip::address &address, unsigned image_width,
-                          unsigned image_height, int fps) {
+                          unsigned image_height, int _fps) {
+  std::lock_guard<std::mutex> control_lock(control_mutex);
   spdlog::info("Start video streamer");
-  encoder = std::make_unique<Encoder>(bitrate, image_width, image_height, fps);
-  start_socket(address);
+  stop_worker();
+  fps = _fps;
+  create_encoder = [backend = backend, format = format, profile = profile, image_width,
+                    image_height, _fps](unsigned value) {
+    return Encoder::create(backend, value, image_width, image_height, _fps, format, profile);
+  };
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stream_min_bitrate = min_bitrate;
+    stream_max_bitrate = max_bitrate;
+    if (stream_max_bitrate && !can_adapt_bitrate()) {
+      spdlog::warn("[Video] The bitrate adapts over TCP only: keep it at {} bps", bitrate);
+      stream_max_bitrate = 0;
+    }
+    encoder_bitrate = stream_max_bitrate
+                          ? std::clamp(bitrate, stream_min_bitrate, stream_max_bitrate)
+                          : bitrate;
+    target_bitrate = encoder_bitrate;
+    width = image_width;
+    height = image_height;
+    stats = VideoStats();
+    stats.bitrate = encoder_bitrate;
+    stream_start = last_adaptation = VideoClock::now();
+    recent_backlog = 0;
+    recent_latency = 0.0;
+    recent_skipped = 0;
+    encoding = true;
+  }
+  encoder = create_encoder(encoder_bitrate);
+  worker = std::thread(&VideoStreamer::encode_frames, this);
+  ba::post(*io_context, [this, address]() { start_socket(address); });
 }
 
 void VideoStreamer::stop() {
+  std::lock_guard<std::mutex> control_lock(control_mutex);
   spdlog::info("Stop video streamer");
   active = false;
+  stop_worker();
   encoder = nullptr;
-  stop_socket();
+  ba::post(*io_context, [this]() { stop_socket(); });
 }
 
 TCPVideoStreamer::TCPVideoStreamer(boost::asio::io_context *io_context, Robot *robot,
                                    std::string ip, unsigned _bitrate)
-    : VideoStreamer(robot, _bitrate)
+    : VideoStreamer(io_context, robot, _bitrate)
     , acceptor(*io_context, ip.size()
                                 ? ba::ip::tcp::endpoint(ba::ip::address::from_string(ip), PORT)
                                 : ba::ip::tcp::endpoint(ba::ip::tcp::v4(), PORT))
-    , tcp_socket(*io_context) {
+    , accept_timer(*io_context)
+    , accepting(false)
+    , streaming(false) {
   spdlog::info("Creating a TCP video streamer on {} @ {} bps", acceptor.local_endpoint(), bitrate);
 }
 
-void TCPVideoStreamer::send_buffer(boost::asio::const_buffer &buffer) {
-  tcp_socket.async_write_some(buffer, [](boost::system::error_code ec, std::size_t bytes_sent) {});
+// Frames are encoded once and shared by all viewers
+void TCPVideoStreamer::send_buffer(std::shared_ptr<const EncodedFrame> frame) {
+  for (const auto &viewer : viewers)
+    send_to(viewer, frame);
+  update_queued_bytes();
 }
 
-void TCPVideoStreamer::start_socket(const ba::ip::address &address) {
-  spdlog::info("Start listening for TCP connections");
+// A decoder cannot use the frames that follow a skipped frame, until the next keyframe: we
+// therefore skip whole groups of frames, and never part of a frame.
+void TCPVideoStreamer::send_to(const std::shared_ptr<Viewer> &viewer,
+                               std::shared_ptr<const EncodedFrame> frame) {
+  const size_t size = frame->packet->size();
+  if (viewer->waiting_for_keyframe && !frame->packet->is_keyframe()) {
+    skipped(*frame);
+    return;
+  }
+  // An empty queue accepts any frame, even if larger than `max_queued_bytes`
+  if (!viewer->write_queue.empty() && viewer->queued_bytes + size > max_queued_bytes) {
+    spdlog::debug("[Video] Connection to {} congested ({} bytes queued)", viewer->endpoint,
+                  viewer->queued_bytes);
+    skipped(*frame, true);
+    viewer->waiting_for_keyframe = true;
+    return;
+  }
+  viewer->waiting_for_keyframe = false;
+  viewer->write_queue.push_back(std::move(frame));
+  viewer->queued_bytes += size;
+  if (viewer->write_queue.size() == 1)
+    write_front(viewer);
+}
+
+void TCPVideoStreamer::write_front(std::shared_ptr<Viewer> viewer) {
+  auto frame = viewer->write_queue.front();
+  const auto &packet = frame->packet;
+  // Completes once all bytes are written (or on error)
+  ba::async_write(viewer->socket, ba::buffer(packet->data(), packet->size()),
+                  [this, viewer, frame](boost::system::error_code ec, std::size_t bytes_sent) {
+                    viewer->write_queue.pop_front();
+                    viewer->queued_bytes -= frame->packet->size();
+                    if (ec) {
+                      spdlog::warn("[Video] Failed to send frame #{}: {}", frame->seq,
+                                   ec.message());
+                      for (const auto &queued_frame : viewer->write_queue)
+                        skipped(*queued_frame);
+                      remove(viewer);
+                      return;
+                    }
+                    sent(*frame, viewer->queued_bytes);
+                    if (!viewer->write_queue.empty())
+                      write_front(viewer);
+                    update_queued_bytes();
+                  });
+}
+
+void TCPVideoStreamer::remove(const std::shared_ptr<Viewer> &viewer) {
+  viewer->write_queue.clear();
+  viewer->queued_bytes = 0;
+  boost::system::error_code ignored;
+  viewer->socket.close(ignored);
+  viewers.erase(std::remove(viewers.begin(), viewers.end(), viewer), viewers.end());
+  spdlog::info("[Video] Viewer {} disconnected ({} left)", viewer->endpoint, viewers.size());
+  active = streaming && !viewers.empty();
+  update_queued_bytes();
+}
+
+void TCPVideoStreamer::update_queued_bytes() {
+  size_t bytes = 0;
+  for (const auto &viewer : viewers)
+    bytes = std::max(bytes, viewer->queued_bytes);
+  queued(bytes);
+}
+
+void TCPVideoStreamer::accept() {
+  accepting = true;
   acceptor.async_accept([this](boost::system::error_code ec, ba::ip::tcp::socket new_socket) {
-    if (!ec) {
-      spdlog::info("Got connection!");
-      tcp_socket = std::move(new_socket);
-      active = true;
+    if (ec == ba::error::operation_aborted) {
+      accepting = false;
+      return;
+    }
+    if (ec) {
+      // The error may persist: do not retry in a tight loop
+      spdlog::warn("[Video] Failed to accept a connection: {}", ec.message());
+      accept_timer.expires_after(accept_retry_period);
+      accept_timer.async_wait([this](const boost::system::error_code &) { accept(); });
+      return;
     }
+    boost::system::error_code ignored;
+    const auto endpoint = new_socket.remote_endpoint(ignored);
+    spdlog::info("Got connection from {}!", endpoint);
+    // Starts at the next keyframe
+    viewers.push_back(std::make_shared<Viewer>(std::move(new_socket), endpoint));
+    active = streaming;
+    accept();
   });
 }
 
-void TCPVideoStreamer::stop_socket() {}
+void TCPVideoStreamer::start_socket(const ba::ip::address &address) {
+  streaming = true;
+  active = !viewers.empty();
+  if (!accepting) {
+    spdlog::info("Start listening for TCP connections");
+    accept();
+  }
+}
+
+void TCPVideoStreamer::stop_socket() {
+  // `accept` and `remove` may have set it again since `stop`
+  streaming = false;
+  active = false;
+  for (const auto &viewer : viewers) {
+    // Keep the frame being written, which its handler will pop
+    auto &queue = viewer->write_queue;
+    if (queue.size() > 1) {
+      for (auto frame = queue.begin() + 1; frame != queue.end(); ++frame)
+        skipped(**frame);
+      queue.erase(queue.begin() + 1, queue.end());
+      viewer->queued_bytes = queue.front()->packet->size();
+    }
+    viewer->waiting_for_keyframe = true;
+  }
+  update_queued_bytes();
+}
 
 UDPVideoStreamer::UDPVideoStreamer(boost::asio::io_context *io_context, Robot *robot,
                                    std::string ip, unsigned _bitrate)
-    : VideoStreamer(robot, _bitrate)
+    : VideoStreamer(io_context, robot, _bitrate)
     , udp_socket(*io_context,
                  ip.size() ? ba::ip::udp::endpoint(ba::ip::address::from_string(ip), UDP_PORT)
-                           : ba::ip::udp::endpoint(ba::ip::udp::v4(), UDP_PORT)) {
+                           : ba::ip::udp::endpoint(ba::ip::udp::v4(), UDP_PORT))
+    , pacing_timer(*io_context)
+    , burst_size(1)
+    , queued_bytes(0)
+    , pacing(false)
+    , split_nal_units(false)
+    , pacing_interval(0.0) {
   spdlog::info("Creating an UDP video streamer on {} @ {} bps", udp_socket.local_endpoint(),
                bitrate);
 }
 
-void UDPVideoStreamer::send_buffer(boost::asio::const_buffer &buffer) {
-  udp_socket.async_send_to(buffer, udp_endpoint,
-                           [](boost::system::error_code ec, std::size_t bytes_sent) {});
+// Datagrams concatenate to the encoded stream, like for TCP, so that clients that read the stream
+// from the datagram payloads are not affected.
+void UDPVideoStreamer::send_buffer(std::shared_ptr<const EncodedFrame> frame) {
+  const auto &packet = frame->packet;
+  const auto chunks = split(packet->data(), packet->size(), max_datagram_size, split_nal_units);
+  for (size_t i = 0; i < chunks.size(); i++) {
+    datagrams.push_back({frame, chunks[i].first, chunks[i].second, i + 1 == chunks.size()});
+  }
+  queued_bytes += packet->size();
+  queued(queued_bytes);
+  const size_t slots = std::max<size_t>(1, pacing_interval / pacing_period);
+  burst_size = (datagrams.size() + slots - 1) / slots;
+  if (!pacing)
+    send_datagrams();
+}
+
+void UDPVideoStreamer::send_datagrams() {
+  for (size_t i = 0; i < burst_size && !datagrams.empty(); i++) {
+    Datagram datagram = std::move(datagrams.front());
+    datagrams.pop_front();
+    queued_bytes -= datagram.size;
+    const auto &packet = datagram.frame->packet;
+    udp_socket.async_send_to(
+        ba::buffer(packet->data() + datagram.offset, datagram.size), udp_endpoint,
+        [this, datagram](boost::system::error_code ec, std::size_t bytes_sent) {
+          if (ec) {
+            spdlog::debug("[Video] Failed to send part of frame #{}: {}", datagram.frame->seq,
+                          ec.message());
+          } else if (datagram.last) {
+            sent(*datagram.frame);
+          }
+        });
+  }
+  queued(queued_bytes);
+  pacing = !datagrams.empty();
+  if (!pacing)
+    return;
+  pacing_timer.expires_after(pacing_period);
+  pacing_timer.async_wait([this](const boost::system::error_code &ec) {
+    if (!ec)
+      send_datagrams();
+  });
 }
 
 void UDPVideoStreamer::start_socket(const ba::ip::address &address) {
   udp_endpoint = ba::ip::udp::endpoint(address, PORT);
+  split_nal_units = get_encoder() == Encoder::x264;
+  // Bursts of datagrams overflow the buffers of switches and receivers: we spread them over
+  // half of the frame interval.
+  pacing_interval = std::chrono::duration<double>(fps > 0 ? 0.5 / fps : 0.0);
   active = true;
 }
 
-void UDPVideoStreamer::stop_socket() {}
+void UDPVideoStreamer::stop_socket() {
+  // `stop` may have been called before the posted `start_socket` ran
+  active = false;
+  pacing_timer.cancel();
+  datagrams.clear();
+  queued_bytes = 0;
+  pacing = false;
+}
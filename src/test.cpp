@@ -17,18 +17,52 @@ static void show_usage(std::string name) {
             << "  --app=<ID>\t\tThe app ID for discovery(default: '')" << std::endl
             << "  --udp\t\t\t\tVideo stream via UDP" << std::endl
             << "  --bitrate=<BITRATE>\t\tVideo stream bitrate (default: 200000)" << std::endl
+            << "  --adaptive_bitrate=<MIN>,<MAX>\tAdapt the video stream bitrate to the connection (TCP)"
+            << std::endl
+            << "  --encoder=<BACKEND>\t\tVideo stream encoder: x264, mjpeg or raw (default: x264)"
+            << std::endl
+            << "  --yuv420\t\t\tEncode the video stream as YUV 4:2:0 instead of RGB" << std::endl
+            << "  --low_latency\t\tEncode the video stream without B-frames nor IDR frames"
+            << std::endl
             << "  --armor_hits\t\t\tPublish armor hits" << std::endl
             << "  --ir_hits\t\t\tPublish IR hits" << std::endl
             << "  --tof=<PORT>\t\t\Enable tof on a port" << std::endl
+            << "  --real_time_topics\t\tPublish topics on wall-clock timers" << std::endl
+            << "  --actions=<POLICY>\t\tNew actions while one of the same type is running: "
+               "reject, queue or preempt (default: reject)"
+            << std::endl
+            << "  --vision_on_change\t\tPush detected objects only when they change" << std::endl
+            << "  --publish=<MODE>\t\tPush subjects always, on_change or deadband (default: always)"
+            << std::endl
+            << "  --deadband=<VALUE>\t\tDeadband in the units of the subjects (default: 0)"
+            << std::endl
+            << "  --keepalive=<PERIOD>\t\tMax time between pushes of unchanged subjects [s] "
+               "(default: 1)"
+            << std::endl
+            << "  --budget=<BYTES/S>\t\tBandwidth budget for topics and video "
+               "(default: 0, no limit)"
+            << std::endl
             << "  --period=<PERIOD>\t\tUpdate step [s] (default: 0.05)" << std::endl;
 }
 
 int main(int argc, char **argv) {
   std::cout << std::endl << "Welcome to the robomaster simulation" << std::endl << std::endl;
   bool use_udp = false;
+  char encoder[100] = "x264";
+  bool yuv420 = false;
+  bool low_latency = false;
   bool armor_hits = false;
   bool ir_hits = false;
+  bool real_time_topics = false;
+  bool vision_on_change = false;
+  char publish_mode[100] = "always";
+  char action_policy[100] = "reject";
+  float deadband = 0.0f;
+  float keepalive = 1.0f;
+  float budget = 0.0f;
   unsigned bitrate = 200000;
+  unsigned min_bitrate = 0;
+  unsigned max_bitrate = 0;
   char serial[100] = "RM0001";
   char log_level[100] = "info";
   char ip[100] = "";
@@ -45,6 +79,20 @@ int main(int argc, char **argv) {
     if (sscanf(argv[i], "--bitrate=%d", &bitrate)) {
       continue;
     }
+    if (sscanf(argv[i], "--adaptive_bitrate=%u,%u", &min_bitrate, &max_bitrate) == 2) {
+      continue;
+    }
+    if (sscanf(argv[i], "--encoder=%99s", encoder)) {
+      continue;
+    }
+    if (strcmp(argv[i], "--yuv420") == 0) {
+      yuv420 = true;
+      continue;
+    }
+    if (strcmp(argv[i], "--low_latency") == 0) {
+      low_latency = true;
+      continue;
+    }
     if (sscanf(argv[i], "--serial_number=%99s", serial)) {
       continue;
     }
@@ -65,6 +113,29 @@ int main(int argc, char **argv) {
       ir_hits = true;
       continue;
     }
+    if (strcmp(argv[i], "--real_time_topics") == 0) {
+      real_time_topics = true;
+      continue;
+    }
+    if (strcmp(argv[i], "--vision_on_change") == 0) {
+      vision_on_change = true;
+      continue;
+    }
+    if (sscanf(argv[i], "--actions=%99s", action_policy)) {
+      continue;
+    }
+    if (sscanf(argv[i], "--publish=%99s", publish_mode)) {
+      continue;
+    }
+    if (sscanf(argv[i], "--deadband=%f", &deadband)) {
+      continue;
+    }
+    if (sscanf(argv[i], "--keepalive=%f", &keepalive)) {
+      continue;
+    }
+    if (sscanf(argv[i], "--budget=%f", &budget)) {
+      continue;
+    }
     if (sscanf(argv[i], "--period=%f", &period)) {
       continue;
     }
@@ -88,6 +159,34 @@ int main(int argc, char **argv) {
   printf("app_id %s\n", app_id);
   RoboMaster robot(io_context, &dummy, std::string(serial), use_udp, bitrate, ip, prefix_len,
                    armor_hits, ir_hits, app_id);
+  robot.set_real_time_topics(real_time_topics);
+  Encoder::Backend backend;
+  if (!encoder_backend_from_string(encoder, &backend)) {
+    show_usage(argv[0]);
+    return 1;
+  }
+  robot.set_video_encoder(backend);
+  robot.set_adaptive_video_bitrate(min_bitrate, max_bitrate);
+  if (yuv420)
+    robot.get_video_streamer()->set_format(Encoder::yuv420p);
+  if (low_latency)
+    robot.get_video_streamer()->set_profile(Encoder::low_latency);
+  robot.set_vision_on_change(vision_on_change);
+  PublishPolicy::Mode mode;
+  if (!publish_mode_from_string(publish_mode, &mode)) {
+    show_usage(argv[0]);
+    return 1;
+  }
+  robot.set_publish_policy("", PublishPolicy(mode, deadband, keepalive));
+  Action::Policy policy;
+  if (!action_policy_from_string(action_policy, &policy)) {
+    show_usage(argv[0]);
+    return 1;
+  }
+  for (size_t kind = 0; kind < Action::number_of_kinds; kind++) {
+    dummy.set_action_policy(static_cast<Action::Kind>(kind), policy);
+  }
+  robot.set_bandwidth_budget(budget);
   for (auto port : tof_ports) {
     printf("port %d\n", port);
     dummy.enable_tof(port);
@@ -1,8 +1,11 @@
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <vector>
 
 #include "encoder.hpp"
 #include "spdlog/spdlog.h"
+#include "yuv.hpp"
 
 struct Image {
   enum Format { raw = 0, h264 = 1 };
@@ -29,18 +32,71 @@ Image generate_strip_image(unsigned i0, unsigned i1, unsigned width, unsigned he
   return image;
 }
 
-constexpr unsigned height = 360;
-constexpr unsigned width = 640;
+using Clock = std::chrono::steady_clock;
 
-int main(int argc, char **argv) {
-  std::cout << std::endl << "Welcome to the H264 encoder test" << std::endl << std::endl;
-  Encoder encoder(100000, width, height, 25);
-  for (size_t i = 0; i < 100; i++) {
+static double milliseconds(Clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+constexpr unsigned number_of_frames = 100;
+
+// Average time [ms] per frame of the conversion to YUV 4:2:0 (scalar and as used by the encoder)
+static void benchmark_conversion(unsigned width, unsigned height) {
+  std::vector<uint8_t> yuv(width * height * 3 / 2);
+  uint8_t *y = yuv.data();
+  uint8_t *u = y + width * height;
+  uint8_t *v = u + width * height / 4;
+  Clock::duration scalar{0};
+  Clock::duration fast{0};
+  for (size_t i = 0; i < number_of_frames; i++) {
+    Image raw_image = generate_strip_image(i, i + 10, width, height);
+    auto start = Clock::now();
+    rgb_to_yuv420p_scalar(raw_image.buffer.data(), width, height, y, width, u, width / 2, v,
+                          width / 2);
+    auto middle = Clock::now();
+    rgb_to_yuv420p(raw_image.buffer.data(), width, height, y, width, u, width / 2, v, width / 2);
+    scalar += middle - start;
+    fast += Clock::now() - middle;
+  }
+  spdlog::info("{}x{} RGB -> YUV420P: scalar {:.2f} ms, {} {:.2f} ms", width, height,
+               milliseconds(scalar) / number_of_frames,
+               rgb_to_yuv420p_is_vectorized() ? "SIMD" : "scalar",
+               milliseconds(fast) / number_of_frames);
+}
+
+// Average time [ms] and size [bytes] per frame of the encoding (including any conversion)
+static void benchmark_encoder(unsigned width, unsigned height, Encoder::Backend backend,
+                              Encoder::Format format = Encoder::rgb24) {
+  auto encoder = Encoder::create(backend, 1000000, width, height, 25, format);
+  FramePool pool;
+  Clock::duration duration{0};
+  size_t bytes = 0;
+  for (size_t i = 0; i < number_of_frames; i++) {
     Image raw_image = generate_strip_image(i, i + 10, width, height);
-    auto data = encoder.encode(raw_image.buffer.data());
-    if (data.size()) {
-      spdlog::info("Will send {} bytes", data.size());
-    }
+    auto frame = pool.lease(width, height);
+    memcpy(frame->data(), raw_image.buffer.data(), frame->size());
+    auto start = Clock::now();
+    auto packet = encoder->encode(frame);
+    duration += Clock::now() - start;
+    if (packet)
+      bytes += packet->size();
+  }
+  const char *names[] = {"x264", "mjpeg", "raw"};
+  const char *format_name = format == Encoder::yuv420p ? " yuv420p" : " rgb24";
+  spdlog::info("{}x{} {}{}: {:.2f} ms/frame, {} bytes/frame", width, height, names[backend],
+               backend == Encoder::x264 ? format_name : "",
+               milliseconds(duration) / number_of_frames, bytes / number_of_frames);
+}
+
+int main(int argc, char **argv) {
+  std::cout << std::endl << "Welcome to the video encoder benchmark" << std::endl << std::endl;
+  const unsigned resolutions[][2] = {{640, 360}, {960, 540}, {1280, 720}};
+  for (const auto &resolution : resolutions) {
+    benchmark_conversion(resolution[0], resolution[1]);
+    benchmark_encoder(resolution[0], resolution[1], Encoder::x264, Encoder::rgb24);
+    benchmark_encoder(resolution[0], resolution[1], Encoder::x264, Encoder::yuv420p);
+    benchmark_encoder(resolution[0], resolution[1], Encoder::mjpeg);
+    benchmark_encoder(resolution[0], resolution[1], Encoder::raw);
   }
   std::cout << std::endl << "Goodbye" << std::endl << std::endl;
   return 0;
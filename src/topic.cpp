@@ -1,42 +1,146 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include "spdlog/spdlog.h"
 
 #include "command.hpp"
 #include "topic.hpp"
 
-void Topic::do_step(float time_step) {
-  // spdlog::info("[TOPIC] do_step {} {}", active, deadline);
-  if (!active)
+void Topic::start() {
+  if (timer)
+    timer->cancel();
+  auto scheduler = server->get_scheduler();
+  timer = scheduler->schedule(1.0f / frequency, std::bind(&Topic::publish, this),
+                              delay(scheduler->get_time()));
+  spdlog::info("[Topic] Start {} @ {} Hz", name(), request.sub_freq);
+}
+
+void Topic::set_frequency(float value) {
+  frequency = value;
+  if (!timer)
     return;
-  deadline -= time_step;
-  while (deadline <= 0) {
-    deadline += 1.0f / request.sub_freq;
-    // spdlog::info("[TOPIC] publish");
-    publish();
-  }
+  timer->cancel();
+  auto scheduler = server->get_scheduler();
+  timer = scheduler->schedule(1.0f / frequency, std::bind(&Topic::publish, this),
+                              delay(scheduler->get_time()));
 }
 
-void Topic::start() {
-  active = true;
-  deadline = 0.0f;
-  // deadline = 1.0f/request.sub_freq;
-  spdlog::info("[Topic] Start {} @ {} Hz", subject->name(), request.sub_freq);
-  // publish();
+float Topic::phase() const {
+  // Golden ratio (Weyl) sequence: consecutive message ids, which clients usually use,
+  // get phases that are as far apart as possible.
+  const unsigned key = (request.node_id << 8) | request.msg_id;
+  const double value = key * 0.6180339887498949;
+  return value - std::floor(value);
+}
+
+float Topic::delay(double time) const {
+  double cycles = time * frequency;
+  double value = phase() - (cycles - std::floor(cycles));
+  if (value < 0)
+    value += 1;
+  return value / frequency;
+}
+
+float Topic::priority() const {
+  float value = 0.0f;
+  for (auto subject : subjects) {
+    value = std::max(value, subject->priority);
+  }
+  return value;
 }
 
 void Topic::stop() {
-  active = false;
-  spdlog::info("[Topic] Stop {}", subject->name());
+  if (!timer)
+    return;
+  timer->cancel();
+  timer = nullptr;
+  spdlog::info("[Topic] Stop {}: {}", name(), stats.summary());
+}
+
+double Topic::now() const { return server->get_scheduler()->get_time(); }
+
+TopicReport Topic::report() {
+  return {name(), request.node_id, request.msg_id, static_cast<float>(request.sub_freq),
+          frequency, stats};
 }
 
 void Topic::publish() {
+  const double time = server->get_scheduler()->get_time();
+  if (!should_push(time)) {
+    stats.skipped++;
+    return;
+  }
+  // Topics faster than the simulation step push the same state more than once
+  if (time == last_publish_time)
+    stats.duplicated++;
+  last_publish_time = time;
+  if (spdlog::should_log(spdlog::level::trace)) {
+    for (auto subject : subjects) {
+      spdlog::trace("[Topic] {} {{{}}}", subject->name(), subject->format());
+    }
+  }
+  push(subject_data());
+}
+
+float Topic::keepalive() const {
+  float value = std::numeric_limits<float>::infinity();
+  for (auto subject : subjects) {
+    if (subject->policy.mode == PublishPolicy::Mode::always)
+      return 0.0f;
+    value = std::min(value, subject->policy.keepalive);
+  }
+  return value;
+}
+
+bool Topic::should_push(double time) {
+  const float period = keepalive();
+  if (period <= 0)
+    return true;
+  bool changed = last_data.size() != subjects.size() || time - last_push_time >= period;
+  for (size_t i = 0; !changed && i < subjects.size(); i++) {
+    changed = subjects[i]->changed(robot, last_data[i], last_values[i]);
+  }
+  if (!changed)
+    return false;
+  last_data.resize(subjects.size());
+  last_values.resize(subjects.size());
+  for (size_t i = 0; i < subjects.size(); i++) {
+    last_data[i] = subjects[i]->data(robot);
+    last_values[i] = subjects[i]->values();
+  }
+  last_push_time = time;
+  return true;
+}
+
+void Topic::push(const std::vector<uint8_t> &payload) {
   PushPeriodMsg::Response response(request);
-  response.subject_data = subject_data();
+  response.subject_data = payload;
   auto data = response.encode_msg(PushPeriodMsg::set, PushPeriodMsg::cmd);
+  // + UDP and IP headers
+  message_size = data.size() + 28;
+  stats.add_push(now(), message_size, 1.0f / frequency);
   spdlog::debug("Push {} bytes: {:n}", data.size(), spdlog::to_hex(data));
   server->send(data);
 }
 
-std::vector<uint8_t> Topic::subject_data() {
-  subject->update(robot);
-  return subject->encode();
+const std::vector<uint8_t> &Topic::subject_data() {
+  if (subjects.size() == 1)
+    return subjects[0]->data(robot);
+  buffer.clear();
+  for (auto subject : subjects) {
+    const auto &data = subject->data(robot);
+    buffer.insert(buffer.end(), data.begin(), data.end());
+  }
+  return buffer;
+}
+
+std::string Topic::name() const {
+  std::string value;
+  for (auto subject : subjects) {
+    if (!value.empty())
+      value += "+";
+    value += subject->name();
+  }
+  return value;
 }
@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <cmath>
+
+#include "spdlog/fmt/fmt.h"
+
+#include "topic_stats.hpp"
+
+TopicStats::TopicStats()
+    : pushes(0)
+    , bytes(0)
+    , skipped(0)
+    , dropped(0)
+    , duplicated(0)
+    , first_push(0.0)
+    , last_push(0.0)
+    , intervals(0)
+    , jitter_sum(0.0)
+    , min_jitter(0.0f)
+    , max_jitter(0.0f)
+    , recent_jitter()
+    , next(0) {}
+
+void TopicStats::add_push(double time, size_t size, float period) {
+  if (pushes) {
+    const float jitter = std::abs(static_cast<float>(time - last_push) - period);
+    if (!intervals || jitter < min_jitter)
+      min_jitter = jitter;
+    if (!intervals || jitter > max_jitter)
+      max_jitter = jitter;
+    jitter_sum += jitter;
+    intervals++;
+    if (recent_jitter.size() < window) {
+      recent_jitter.push_back(jitter);
+    } else {
+      recent_jitter[next] = jitter;
+      next = (next + 1) % window;
+    }
+  } else {
+    first_push = time;
+  }
+  last_push = time;
+  pushes++;
+  bytes += size;
+}
+
+float TopicStats::rate() const {
+  if (pushes < 2 || last_push <= first_push)
+    return 0.0f;
+  return (pushes - 1) / (last_push - first_push);
+}
+
+float TopicStats::jitter_min() const { return min_jitter; }
+
+float TopicStats::jitter_avg() const { return intervals ? jitter_sum / intervals : 0.0f; }
+
+float TopicStats::jitter_max() const { return max_jitter; }
+
+float TopicStats::jitter_p99() const {
+  if (recent_jitter.empty())
+    return 0.0f;
+  std::vector<float> values = recent_jitter;
+  auto p99 = values.begin() + (values.size() - 1) * 99 / 100;
+  std::nth_element(values.begin(), p99, values.end());
+  return *p99;
+}
+
+std::string TopicStats::summary() const {
+  return fmt::format(
+      "{} pushes @ {:.2f} Hz, {} bytes, jitter min/avg/max/p99 {:.1f}/{:.1f}/{:.1f}/{:.1f} ms, "
+      "{} skipped, {} dropped, {} duplicated",
+      pushes, rate(), bytes, 1e3 * jitter_min(), 1e3 * jitter_avg(), 1e3 * jitter_max(),
+      1e3 * jitter_p99(), skipped, dropped, duplicated);
+}
@@ -0,0 +1,171 @@
+#include <array>
+
+#include "yuv.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define YUV_SSSE3
+#include <tmmintrin.h>
+#endif
+
+static inline uint8_t luma(int r, int g, int b) {
+  return static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+
+static inline uint8_t chroma_u(int r, int g, int b) {
+  return static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+}
+
+static inline uint8_t chroma_v(int r, int g, int b) {
+  return static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+}
+
+// Convert columns [x_begin, x_end) of two consecutive rows
+static void convert_rows(const uint8_t *rgb_0, const uint8_t *rgb_1, unsigned x_begin,
+                         unsigned x_end, uint8_t *y_0, uint8_t *y_1, uint8_t *u, uint8_t *v) {
+  for (unsigned x = x_begin; x < x_end; x += 2) {
+    int r = 0, g = 0, b = 0;
+    for (const uint8_t *p : {rgb_0 + 3 * x, rgb_0 + 3 * x + 3, rgb_1 + 3 * x, rgb_1 + 3 * x + 3}) {
+      r += p[0];
+      g += p[1];
+      b += p[2];
+    }
+    y_0[x] = luma(rgb_0[3 * x], rgb_0[3 * x + 1], rgb_0[3 * x + 2]);
+    y_0[x + 1] = luma(rgb_0[3 * x + 3], rgb_0[3 * x + 4], rgb_0[3 * x + 5]);
+    y_1[x] = luma(rgb_1[3 * x], rgb_1[3 * x + 1], rgb_1[3 * x + 2]);
+    y_1[x + 1] = luma(rgb_1[3 * x + 3], rgb_1[3 * x + 4], rgb_1[3 * x + 5]);
+    r = (r + 2) >> 2;
+    g = (g + 2) >> 2;
+    b = (b + 2) >> 2;
+    u[x / 2] = chroma_u(r, g, b);
+    v[x / 2] = chroma_v(r, g, b);
+  }
+}
+
+void rgb_to_yuv420p_scalar(const uint8_t *rgb, unsigned width, unsigned height, uint8_t *y,
+                           int y_stride, uint8_t *u, int u_stride, uint8_t *v, int v_stride) {
+  const size_t rgb_stride = 3 * width;
+  for (unsigned j = 0; j < height; j += 2) {
+    const uint8_t *row = rgb + j * rgb_stride;
+    convert_rows(row, row + rgb_stride, 0, width, y + j * y_stride, y + (j + 1) * y_stride,
+                 u + j / 2 * u_stride, v + j / 2 * v_stride);
+  }
+}
+
+#ifdef YUV_SSSE3
+
+// Shuffles that gather channel `c` of 16 pixels from the k-th block of 16 bytes
+static constexpr std::array<std::array<std::array<int8_t, 16>, 3>, 3> make_shuffles() {
+  std::array<std::array<std::array<int8_t, 16>, 3>, 3> shuffles{};
+  for (int c = 0; c < 3; c++) {
+    for (int k = 0; k < 3; k++) {
+      for (int i = 0; i < 16; i++) {
+        const int index = 3 * i + c - 16 * k;
+        shuffles[c][k][i] = (index >= 0 && index < 16) ? index : -128;
+      }
+    }
+  }
+  return shuffles;
+}
+
+alignas(16) static constexpr auto shuffles = make_shuffles();
+
+__attribute__((target("ssse3"))) static inline __m128i channel(__m128i b0, __m128i b1,
+                                                                 __m128i b2, int c) {
+  const auto &s = shuffles[c];
+  return _mm_or_si128(
+      _mm_or_si128(_mm_shuffle_epi8(b0, _mm_load_si128(reinterpret_cast<const __m128i *>(&s[0]))),
+                   _mm_shuffle_epi8(b1, _mm_load_si128(reinterpret_cast<const __m128i *>(&s[1])))),
+      _mm_shuffle_epi8(b2, _mm_load_si128(reinterpret_cast<const __m128i *>(&s[2]))));
+}
+
+// a * x + b * y + c * z + d, in 16 bits
+__attribute__((target("ssse3"))) static inline __m128i combine(__m128i x, __m128i y, __m128i z,
+                                                                 int16_t a, int16_t b, int16_t c,
+                                                                 int16_t d) {
+  return _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(x, _mm_set1_epi16(a)),
+                                     _mm_mullo_epi16(y, _mm_set1_epi16(b))),
+                       _mm_add_epi16(_mm_mullo_epi16(z, _mm_set1_epi16(c)), _mm_set1_epi16(d)));
+}
+
+// 16 pixels of one row: stores their luma and returns the channels, widened to 16 bits
+__attribute__((target("ssse3"))) static inline void convert_16(const uint8_t *rgb, uint8_t *y,
+                                                                 __m128i *channels) {
+  const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rgb));
+  const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rgb + 16));
+  const __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rgb + 32));
+  const __m128i zero = _mm_setzero_si128();
+  __m128i luma[2];
+  for (int c = 0; c < 3; c++) {
+    const __m128i values = channel(b0, b1, b2, c);
+    channels[2 * c] = _mm_unpacklo_epi8(values, zero);
+    channels[2 * c + 1] = _mm_unpackhi_epi8(values, zero);
+  }
+  for (int h = 0; h < 2; h++) {
+    // The sum is at most 56228: it fits in 16 unsigned bits
+    luma[h] = _mm_add_epi16(
+        _mm_srli_epi16(combine(channels[h], channels[2 + h], channels[4 + h], 66, 129, 25, 128), 8),
+        _mm_set1_epi16(16));
+  }
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(y), _mm_packus_epi16(luma[0], luma[1]));
+}
+
+__attribute__((target("ssse3"))) static void rgb_to_yuv420p_ssse3(
+    const uint8_t *rgb, unsigned width, unsigned height, uint8_t *y, int y_stride, uint8_t *u,
+    int u_stride, uint8_t *v, int v_stride) {
+  const size_t rgb_stride = 3 * width;
+  const unsigned vector_width = width & ~15u;
+  const __m128i two = _mm_set1_epi16(2);
+  const __m128i bias = _mm_set1_epi16(128);
+  for (unsigned j = 0; j < height; j += 2) {
+    const uint8_t *rgb_0 = rgb + j * rgb_stride;
+    const uint8_t *rgb_1 = rgb_0 + rgb_stride;
+    uint8_t *y_0 = y + j * y_stride;
+    uint8_t *y_1 = y_0 + y_stride;
+    uint8_t *u_row = u + j / 2 * u_stride;
+    uint8_t *v_row = v + j / 2 * v_stride;
+    for (unsigned x = 0; x < vector_width; x += 16) {
+      __m128i channels_0[6];
+      __m128i channels_1[6];
+      convert_16(rgb_0 + 3 * x, y_0 + x, channels_0);
+      convert_16(rgb_1 + 3 * x, y_1 + x, channels_1);
+      // The averages of the 2x2 blocks
+      __m128i mean[3];
+      for (int c = 0; c < 3; c++) {
+        const __m128i sum = _mm_hadd_epi16(_mm_add_epi16(channels_0[2 * c], channels_1[2 * c]),
+                                           _mm_add_epi16(channels_0[2 * c + 1],
+                                                         channels_1[2 * c + 1]));
+        mean[c] = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+      }
+      // |sum| <= 28688: it fits in 16 signed bits
+      const __m128i u_8 = _mm_add_epi16(
+          _mm_srai_epi16(combine(mean[0], mean[1], mean[2], -38, -74, 112, 128), 8), bias);
+      const __m128i v_8 = _mm_add_epi16(
+          _mm_srai_epi16(combine(mean[0], mean[1], mean[2], 112, -94, -18, 128), 8), bias);
+      _mm_storel_epi64(reinterpret_cast<__m128i *>(u_row + x / 2), _mm_packus_epi16(u_8, u_8));
+      _mm_storel_epi64(reinterpret_cast<__m128i *>(v_row + x / 2), _mm_packus_epi16(v_8, v_8));
+    }
+    convert_rows(rgb_0, rgb_1, vector_width, width, y_0, y_1, u_row, v_row);
+  }
+}
+
+#endif  // YUV_SSSE3
+
+bool rgb_to_yuv420p_is_vectorized() {
+#ifdef YUV_SSSE3
+  static const bool value = __builtin_cpu_supports("ssse3");
+  return value;
+#else
+  return false;
+#endif
+}
+
+void rgb_to_yuv420p(const uint8_t *rgb, unsigned width, unsigned height, uint8_t *y,
+                    int y_stride, uint8_t *u, int u_stride, uint8_t *v, int v_stride) {
+#ifdef YUV_SSSE3
+  if (rgb_to_yuv420p_is_vectorized()) {
+    rgb_to_yuv420p_ssse3(rgb, width, height, y, y_stride, u, u_stride, v, v_stride);
+    return;
+  }
+#endif
+  rgb_to_yuv420p_scalar(rgb, width, height, y, y_stride, u, u_stride, v, v_stride);
+}